@@ -0,0 +1,99 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Penrose.h"
+
+/*
+ * Throughput and memory of the Penrose generator for each scalar it can be instantiated with.
+ * Every level is generated in the scalar and converted to float vertices once, the same way
+ * the renderer receives them. The error column is the largest distance between the first
+ * vertices of the tilling and the same vertices generated with double.
+ *
+ * Usage: PenroseBench [minLevel] [maxLevel]   ( default 10 16, level 16 needs ~8 GB for double )
+ */
+
+namespace{
+
+const int REFERENCE_TRIANGLES = 4096;
+
+typedef std::chrono::steady_clock Clock;
+
+double MillisecondsSince( Clock::time_point start ){
+	return std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+}
+
+template<typename T>
+std::vector<glm::dvec3> ReferencePositions( const TriangleList<T> &triangles ){
+	std::vector<glm::dvec3> positions;
+	for( size_t i = 0; i < triangles.size() && i < REFERENCE_TRIANGLES; i++ ){
+		const TriangleT<T> &t = triangles[ i ];
+		positions.push_back( glm::dvec3( static_cast< double >( t.a.x ), static_cast< double >( t.a.y ), static_cast< double >( t.a.z ) ) );
+		positions.push_back( glm::dvec3( static_cast< double >( t.b.x ), static_cast< double >( t.b.y ), static_cast< double >( t.b.z ) ) );
+		positions.push_back( glm::dvec3( static_cast< double >( t.c.x ), static_cast< double >( t.c.y ), static_cast< double >( t.c.z ) ) );
+	}
+	return positions;
+}
+
+template<typename T>
+void Run( const char *name, int level, const std::vector<glm::dvec3> &reference ){
+	Clock::time_point start = Clock::now();
+	PenroseT<T> p( level, CoordinateT<T>( T( 0.0 ), T( 0.0 ) ), 36, 1.0f );
+	p.execute();
+	double generate = MillisecondsSince( start );
+
+	const TriangleList<T> &triangles = p.GetTriangles();
+
+	// Conversion to float happens here and only here
+	start = Clock::now();
+	std::vector<float> vertices( triangles.size() * 9 );
+	float *out = vertices.data();
+	for( const TriangleT<T> &t : triangles ){
+		glm::vec3 corners[ 3 ] = { t.a.ToVec3(), t.b.ToVec3(), t.c.ToVec3() };
+		for( const glm::vec3 &corner : corners ){
+			*out++ = corner.x;
+			*out++ = corner.y;
+			*out++ = corner.z;
+		}
+	}
+	double emit = MillisecondsSince( start );
+
+	double error = 0.0;
+	std::vector<glm::dvec3> positions = ReferencePositions( triangles );
+	for( size_t i = 0; i < positions.size() && i < reference.size(); i++ )
+		error = std::max( error, glm::length( positions[ i ] - reference[ i ] ) );
+
+	double count = ( double ) triangles.size();
+	double bytes = ( double ) triangles.capacity() * sizeof( TriangleT<T> );
+
+	printf( "%-8s %5d %12.0f %10.2f %10.2f %10.2f %9d %10.1f %12.3e\n",
+		name, level, count, generate, emit, count / ( generate / 1000.0 ) / 1e6,
+		( int ) sizeof( TriangleT<T> ), bytes / ( 1024.0 * 1024.0 ), error );
+	fflush( stdout );
+}
+
+}
+
+int main( int argc, char **argv ){
+	int minLevel = argc > 1 ? atoi( argv[ 1 ] ) : 10;
+	int maxLevel = argc > 2 ? atoi( argv[ 2 ] ) : 16;
+
+	printf( "%-8s %5s %12s %10s %10s %10s %9s %10s %12s\n",
+		"scalar", "level", "triangles", "gen_ms", "emit_ms", "Mtri/s", "B/tri", "MB", "max_error" );
+
+	for( int level = minLevel; level <= maxLevel; level++ ){
+		std::vector<glm::dvec3> reference;
+		{
+			PenroseT<double> p( level, CoordinateT<double>( 0.0, 0.0 ), 36, 1.0f );
+			p.execute();
+			reference = ReferencePositions( p.GetTriangles() );
+		}
+
+		Run<float>( "float", level, reference );
+		Run<double>( "double", level, reference );
+		Run<Fixed32>( "fixed32", level, reference );
+	}
+
+	return 0;
+}
@@ -0,0 +1,357 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Penrose.h"
+#include "PenroseStats.h"
+#include "ProcessMemory.h"
+#include "Profiler.h"
+
+/*
+ * Batch generation of tillings without a window or GL context. Every combination of level
+ * and seed is generated, optionally extruded and written, and the time of each stage is
+ * reported as JSON so jobs can be scheduled from the numbers.
+ *
+ * Usage: PenroseCLI [options]
+ *   --levels A[-B]       Deflations, one level or an inclusive range ( 5 )
+ *   --seeds D[,D...]     Seed angles, each seed is 360 / D triangles ( 36 )
+ *   --engine E           Scalar of the generator: float, double or fixed ( float )
+ *   --extrude            Build the 3D pyramids with DoIt3D
+ *   --extrusion-height H Height of the pyramids ( 1 ), |H| + 1 must be under 8 for the fixed engine
+ *   --apex A             vertex or centroid, where the pyramid apex sits ( vertex )
+ *   --format F           none, raw or obj ( none ), raw is the float vertex buffer of the renderer
+ *   --out PREFIX         Files are PREFIX_l<level>_s<seed>.<format> ( penrose )
+ *   --stats              Report the triangle counts, areas and vertex configurations of PenroseStats
+ *   --threads N          Worker threads for the extrusion and the stats, 0 for one per hardware thread ( 0 )
+ *   --json FILE          Where the report goes, - for stdout ( - )
+ *   --trace FILE         Chrome trace of the run, needs a build with PENROSE_PROFILE
+ */
+
+namespace{
+
+typedef std::chrono::steady_clock Clock;
+
+// Distance of the corners of the seed triangles from the origin, the flat tilling stays inside it
+const float SEED_RADIUS = 1.0f;
+
+double MillisecondsSince( Clock::time_point start ){
+	return std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+}
+
+struct Options{
+	int minLevel = 5;
+	int maxLevel = 5;
+	std::vector<int> seeds = { 36 };
+	std::string engine = "float";
+	bool extrude = false;
+	bool stats = false;
+	float extrusionHeight = 1.0f;
+	ExtrusionApex apex = ExtrusionApex::VertexA;
+	std::string format = "none";
+	std::string out = "penrose";
+	unsigned int threads = 0;
+	std::string json = "-";
+	std::string trace;
+};
+
+struct Stage{
+	const char *name;
+	double milliseconds;
+	size_t peakResidentBytes;
+};
+
+struct Run{
+	int level;
+	int seed;
+	size_t triangles;
+	size_t vertexBytes;
+	// Most the arena held during the runs so far
+	size_t arenaHighWaterBytes;
+	std::string file;
+	std::vector<Stage> stages;
+	// With --stats, measured on the flat tilling and expected from the substitution matrix
+	bool hasStats;
+	GeometricStats measured;
+	LevelStats analytic;
+};
+
+void PrintUsage(){
+	fprintf( stderr, "Usage: PenroseCLI [--levels A[-B]] [--seeds D[,D...]] [--engine float|double|fixed]\n"
+		"                  [--extrude] [--extrusion-height H] [--apex vertex|centroid] [--stats]\n"
+		"                  [--format none|raw|obj] [--out PREFIX] [--threads N] [--json FILE] [--trace FILE]\n" );
+}
+
+// @return false when an option is unknown or has a bad value
+bool ParseOptions( int argc, char **argv, Options &options ){
+	for( int i = 1; i < argc; i++ ){
+		std::string name = argv[ i ];
+		if( name == "--extrude" ){
+			options.extrude = true;
+			continue;
+		}
+		if( name == "--stats" ){
+			options.stats = true;
+			continue;
+		}
+
+		if( i + 1 >= argc )
+			return false;
+		std::string value = argv[ ++i ];
+
+		if( name == "--levels" ){
+			int count = sscanf( value.c_str(), "%d-%d", &options.minLevel, &options.maxLevel );
+			if( count == 1 )
+				options.maxLevel = options.minLevel;
+			else if( count != 2 )
+				return false;
+		} else if( name == "--seeds" ){
+			options.seeds.clear();
+			std::stringstream ss( value );
+			std::string seed;
+			while( std::getline( ss, seed, ',' ) ){
+				int degree = atoi( seed.c_str() );
+				if( degree <= 0 || degree > 360 )
+					return false;
+				options.seeds.push_back( degree );
+			}
+		} else if( name == "--engine" ){
+			options.engine = value;
+		} else if( name == "--extrusion-height" ){
+			options.extrusionHeight = ( float ) atof( value.c_str() );
+		} else if( name == "--apex" ){
+			if( value == "vertex" )
+				options.apex = ExtrusionApex::VertexA;
+			else if( value == "centroid" )
+				options.apex = ExtrusionApex::Centroid;
+			else
+				return false;
+		} else if( name == "--format" ){
+			options.format = value;
+		} else if( name == "--out" ){
+			options.out = value;
+		} else if( name == "--threads" ){
+			options.threads = ( unsigned int ) atoi( value.c_str() );
+		} else if( name == "--json" ){
+			options.json = value;
+		} else if( name == "--trace" ){
+			options.trace = value;
+		} else{
+			return false;
+		}
+	}
+
+	// The fixed engine wraps past its range, the apexes of DoIt3D are as far as the tilling gets
+	if( options.engine == "fixed" && options.extrude && std::abs( options.extrusionHeight ) + SEED_RADIUS >= Fixed32::RANGE ){
+		fprintf( stderr, "Error: --engine fixed needs |extrusion-height| + %g < %g\n", SEED_RADIUS, Fixed32::RANGE );
+		return false;
+	}
+
+	return options.minLevel >= 0 && options.minLevel <= options.maxLevel && !options.seeds.empty() &&
+		( options.engine == "float" || options.engine == "double" || options.engine == "fixed" ) &&
+		( options.format == "none" || options.format == "raw" || options.format == "obj" );
+}
+
+// @return false if the file can't be written
+bool WriteRaw( const std::string &path, const float *vertices, size_t floats ){
+	FILE *file = fopen( path.c_str(), "wb" );
+	if( !file )
+		return false;
+
+	bool written = fwrite( vertices, sizeof( float ), floats, file ) == floats;
+	return fclose( file ) == 0 && written;
+}
+
+// Positions, texture coordinates and normals of the 12 float vertex layout, one face per triangle
+bool WriteObj( const std::string &path, const float *vertices, size_t vertexCount ){
+	FILE *file = fopen( path.c_str(), "w" );
+	if( !file )
+		return false;
+
+	for( size_t i = 0; i < vertexCount; i++ ){
+		const float *v = vertices + i * 12;
+		fprintf( file, "v %g %g %g\nvt %g %g\nvn %g %g %g\n", v[ 0 ], v[ 1 ], v[ 2 ], v[ 6 ], v[ 7 ], v[ 9 ], v[ 10 ], v[ 11 ] );
+	}
+	for( size_t i = 1; i + 2 <= vertexCount; i += 3 )
+		fprintf( file, "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", i, i, i, i + 1, i + 1, i + 1, i + 2, i + 2, i + 2 );
+
+	return fclose( file ) == 0;
+}
+
+// Every buffer of the run is taken from the arena, which is reset at the start so runs share its memory
+template<typename T>
+bool Generate( const Options &options, int level, int seed, Arena &arena, Run &run ){
+	run.level = level;
+	run.seed = seed;
+	run.vertexBytes = 0;
+	run.hasStats = false;
+	arena.Reset();
+
+	Clock::time_point start = Clock::now();
+	PenroseT<T> p( level, CoordinateT<T>( T( 0.0 ), T( 0.0 ) ), seed, SEED_RADIUS, &arena );
+	p.execute();
+	run.stages.push_back( { "generate", MillisecondsSince( start ), PeakResidentBytes() } );
+
+	// Before DoIt3D, the stats are of the flat tiles
+	if( options.stats ){
+		start = Clock::now();
+		run.measured = PenroseStats::Measure( p.GetTriangles(), options.threads );
+		run.analytic = PenroseStats::Analytic( level, BigUInt( 360 / seed ), BigUInt( 0 ), SEED_RADIUS ).back();
+		run.hasStats = true;
+		run.stages.push_back( { "stats", MillisecondsSince( start ), PeakResidentBytes() } );
+	}
+
+	if( options.extrude ){
+		start = Clock::now();
+		p.DoIt3D( options.extrusionHeight, options.apex, options.threads );
+		run.stages.push_back( { "extrude", MillisecondsSince( start ), PeakResidentBytes() } );
+	}
+
+	run.triangles = p.GetTriangles().size();
+	run.arenaHighWaterBytes = arena.GetHighWaterMark();
+	if( options.format == "none" )
+		return true;
+
+	start = Clock::now();
+	const float *vertices = p.GetVerticesWithColorsTexCoordsAndNormalLight();
+	size_t vertexCount = run.triangles * 3;
+	run.vertexBytes = vertexCount * 12 * sizeof( float );
+	run.stages.push_back( { "serialize", MillisecondsSince( start ), PeakResidentBytes() } );
+	run.arenaHighWaterBytes = arena.GetHighWaterMark();
+
+	run.file = options.out + "_l" + std::to_string( level ) + "_s" + std::to_string( seed ) + "." + options.format;
+
+	start = Clock::now();
+	bool written = options.format == "raw"
+		? WriteRaw( run.file, vertices, vertexCount * 12 )
+		: WriteObj( run.file, vertices, vertexCount );
+	run.stages.push_back( { "write", MillisecondsSince( start ), PeakResidentBytes() } );
+
+	if( !written )
+		fprintf( stderr, "Error: can't write %s\n", run.file.c_str() );
+	return written;
+}
+
+// @return text as the inside of a JSON string, paths on Windows have backslashes
+std::string JsonEscape( const std::string &text ){
+	std::string escaped;
+	escaped.reserve( text.size() );
+	for( char c : text ){
+		switch( c ){
+			case '"':	escaped += "\\\""; break;
+			case '\\':	escaped += "\\\\"; break;
+			case '\n':	escaped += "\\n"; break;
+			case '\r':	escaped += "\\r"; break;
+			case '\t':	escaped += "\\t"; break;
+			default:
+				if( ( unsigned char ) c < 0x20 ){
+					char code[ 7 ];
+					snprintf( code, sizeof( code ), "\\u%04x", ( unsigned int ) c );
+					escaped += code;
+				} else
+					escaped += c;
+		}
+	}
+	return escaped;
+}
+
+// The counts of Analytic are exact integers of any size, which JSON numbers can hold
+void WriteStats( FILE *file, const Run &run ){
+	const GeometricStats &measured = run.measured;
+	fprintf( file, "      \"stats\": {\n        \"thin_triangles\": %llu,\n        \"thick_triangles\": %llu,\n"
+		"        \"analytic_thin_triangles\": %s,\n        \"analytic_thick_triangles\": %s,\n        \"thick_thin_ratio\": %.15Lf,\n"
+		"        \"thin_area\": %.9f,\n        \"thick_area\": %.9f,\n        \"total_area\": %.9f,\n"
+		"        \"interior_vertices\": %llu,\n        \"boundary_vertices\": %llu,\n        \"vertex_configurations\": {",
+		( unsigned long long ) measured.thinTriangles, ( unsigned long long ) measured.thickTriangles,
+		run.analytic.thinTriangles.ToString().c_str(), run.analytic.thickTriangles.ToString().c_str(), run.analytic.thickThinRatio,
+		measured.thinArea, measured.thickArea, measured.totalArea,
+		( unsigned long long ) measured.interiorVertices, ( unsigned long long ) measured.boundaryVertices );
+
+	const char *separator = "";
+	for( const auto &configuration : measured.vertexConfigurations ){
+		fprintf( file, "%s\n          \"%s\": %llu", separator, JsonEscape( configuration.first ).c_str(), ( unsigned long long ) configuration.second );
+		separator = ",";
+	}
+	fprintf( file, "%s}\n      },\n", measured.vertexConfigurations.empty() ? "" : "\n        " );
+}
+
+void WriteJson( FILE *file, const Options &options, const std::vector<Run> &runs ){
+	fprintf( file, "{\n  \"engine\": \"%s\",\n  \"extrude\": %s,\n  \"format\": \"%s\",\n  \"runs\": [\n",
+		JsonEscape( options.engine ).c_str(), options.extrude ? "true" : "false", JsonEscape( options.format ).c_str() );
+
+	for( size_t r = 0; r < runs.size(); r++ ){
+		const Run &run = runs[ r ];
+		double total = 0.0;
+		for( const Stage &stage : run.stages )
+			total += stage.milliseconds;
+
+		fprintf( file, "    {\n      \"level\": %d,\n      \"seed\": %d,\n      \"triangles\": %zu,\n      \"vertex_bytes\": %zu,\n      \"arena_high_water_bytes\": %zu,\n",
+			run.level, run.seed, run.triangles, run.vertexBytes, run.arenaHighWaterBytes );
+		if( !run.file.empty() )
+			fprintf( file, "      \"file\": \"%s\",\n", JsonEscape( run.file ).c_str() );
+		if( run.hasStats )
+			WriteStats( file, run );
+
+		fprintf( file, "      \"stages\": [\n" );
+		for( size_t s = 0; s < run.stages.size(); s++ ){
+			const Stage &stage = run.stages[ s ];
+			fprintf( file, "        { \"name\": \"%s\", \"wall_ms\": %.3f, \"peak_rss_bytes\": %zu }%s\n",
+				stage.name, stage.milliseconds, stage.peakResidentBytes, s + 1 < run.stages.size() ? "," : "" );
+		}
+		fprintf( file, "      ],\n" );
+
+		fprintf( file, "      \"total_ms\": %.3f,\n      \"triangles_per_second\": %.0f\n    }%s\n",
+			total, total > 0.0 ? run.triangles / ( total / 1000.0 ) : 0.0, r + 1 < runs.size() ? "," : "" );
+	}
+
+	fprintf( file, "  ],\n  \"peak_rss_bytes\": %zu\n}\n", PeakResidentBytes() );
+}
+
+}
+
+int main( int argc, char **argv ){
+	Options options;
+	if( !ParseOptions( argc, argv, options ) ){
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<Run> runs;
+	Arena arena;
+	bool succeeded = true;
+	for( int level = options.minLevel; level <= options.maxLevel; level++ ){
+		for( int seed : options.seeds ){
+			runs.push_back( Run() );
+			if( options.engine == "double" )
+				succeeded &= Generate<double>( options, level, seed, arena, runs.back() );
+			else if( options.engine == "fixed" )
+				succeeded &= Generate<Fixed32>( options, level, seed, arena, runs.back() );
+			else
+				succeeded &= Generate<float>( options, level, seed, arena, runs.back() );
+		}
+	}
+
+	FILE *json = options.json == "-" ? stdout : fopen( options.json.c_str(), "w" );
+	if( !json ){
+		fprintf( stderr, "Error: can't write %s\n", options.json.c_str() );
+		return 1;
+	}
+
+	WriteJson( json, options, runs );
+	if( json != stdout )
+		fclose( json );
+
+	if( !options.trace.empty() ){
+#ifdef PENROSE_PROFILE
+		if( !Profiler::WriteChromeTrace( options.trace ) )
+			fprintf( stderr, "Error: can't write %s\n", options.trace.c_str() );
+#else
+		fprintf( stderr, "Warning: built without PENROSE_PROFILE, no trace written\n" );
+#endif
+	}
+
+	return succeeded ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Parallel.h"
+#include "Penrose.h"
+#include "SubstitutionDag.h"
+
+/*
+ * Microbenchmarks of the generation and serialisation hot paths: deflate, execute, DoIt3D,
+ * every WriteVertices format, RotatePoint3D and the batched Rotate. Every stage runs at each
+ * level, the threaded ones once per thread count, and the results are printed as CSV or JSON
+ * so two versions can be diffed.
+ *
+ * ns_per_tile is the fastest repetition over the tiles the stage produces, bytes_per_tile and
+ * allocs_per_run count every operator new of the first repetition, speedup is against 1 thread.
+ *
+ * Usage: PenroseMicroBench [options]
+ *   --levels A-B         Levels to run ( 4-16 ), level 16 needs several GB
+ *   --threads N[,N...]   Thread counts for the threaded stages ( 1, 2, 4 ... hardware threads )
+ *   --stages S[,S...]    Subset of deflate, execute, DoIt3D, GetVertices, RotatePoint3D, Rotate ( all )
+ *   --budget MS          Time spent repeating each measurement ( 200 )
+ *   --format F           csv or json ( csv )
+ *   --out FILE           Where the results go ( stdout )
+ */
+
+namespace{
+
+std::atomic<uint64_t> g_Allocations( 0 );
+std::atomic<uint64_t> g_AllocatedBytes( 0 );
+
+}
+
+// Every allocation of the process goes through these, so the counters see vectors and threads alike
+void *operator new( size_t size ){
+	g_Allocations.fetch_add( 1, std::memory_order_relaxed );
+	g_AllocatedBytes.fetch_add( size, std::memory_order_relaxed );
+
+	if( void *p = malloc( size ? size : 1 ) )
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new[]( size_t size ){
+	return operator new( size );
+}
+
+void operator delete( void *p ) noexcept{
+	free( p );
+}
+
+void operator delete[]( void *p ) noexcept{
+	free( p );
+}
+
+void operator delete( void *p, size_t ) noexcept{
+	free( p );
+}
+
+void operator delete[]( void *p, size_t ) noexcept{
+	free( p );
+}
+
+namespace{
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options{
+	int minLevel = 4;
+	int maxLevel = 16;
+	std::vector<unsigned int> threads;
+	std::vector<std::string> stages = { "deflate", "execute", "DoIt3D", "GetVertices", "RotatePoint3D", "Rotate" };
+	double budget = 200.0;
+	std::string format = "csv";
+	std::string out = "-";
+};
+
+struct Result{
+	std::string stage;
+	std::string variant;
+	int level;
+	unsigned int threads;
+	size_t tiles;
+	int repetitions;
+	double nsPerTile;
+	double bytesPerTile;
+	uint64_t allocsPerRun;
+	double speedup;
+};
+
+// A measured stage: setup is not timed and runs before every repetition, body is timed
+struct Case{
+	std::function<void()> setup;
+	std::function<void()> body;
+};
+
+void PrintUsage(){
+	fprintf( stderr, "Usage: PenroseMicroBench [--levels A-B] [--threads N[,N...]] [--stages S[,S...]]\n"
+		"                         [--budget MS] [--format csv|json] [--out FILE]\n" );
+}
+
+std::vector<std::string> Split( const std::string &value ){
+	std::vector<std::string> items;
+	std::stringstream ss( value );
+	std::string item;
+	while( std::getline( ss, item, ',' ) )
+		if( !item.empty() )
+			items.push_back( item );
+	return items;
+}
+
+// @return false when an option is unknown or has a bad value
+bool ParseOptions( int argc, char **argv, Options &options ){
+	for( int i = 1; i < argc; i++ ){
+		std::string name = argv[ i ];
+		if( i + 1 >= argc )
+			return false;
+		std::string value = argv[ ++i ];
+
+		if( name == "--levels" ){
+			int count = sscanf( value.c_str(), "%d-%d", &options.minLevel, &options.maxLevel );
+			if( count == 1 )
+				options.maxLevel = options.minLevel;
+			else if( count != 2 )
+				return false;
+		} else if( name == "--threads" ){
+			options.threads.clear();
+			for( const std::string &count : Split( value ) )
+				options.threads.push_back( ( unsigned int ) std::max( 1, atoi( count.c_str() ) ) );
+		} else if( name == "--stages" ){
+			options.stages = Split( value );
+		} else if( name == "--budget" ){
+			options.budget = atof( value.c_str() );
+		} else if( name == "--format" ){
+			options.format = value;
+		} else if( name == "--out" ){
+			options.out = value;
+		} else{
+			return false;
+		}
+	}
+
+	if( options.threads.empty() ){
+		for( unsigned int count = 1; count < HardwareThreads(); count *= 2 )
+			options.threads.push_back( count );
+		options.threads.push_back( HardwareThreads() );
+	}
+
+	return options.minLevel >= 0 && options.minLevel <= options.maxLevel &&
+		( options.format == "csv" || options.format == "json" );
+}
+
+bool Enabled( const Options &options, const std::string &stage ){
+	return std::find( options.stages.begin(), options.stages.end(), stage ) != options.stages.end();
+}
+
+// Repeat the case until the budget is spent, at least once, and keep the fastest repetition
+Result Measure( const Options &options, const Case &c, size_t tiles ){
+	Result result = Result();
+	result.tiles = tiles;
+
+	double best = 0.0, spent = 0.0;
+	do{
+		if( c.setup )
+			c.setup();
+
+		uint64_t allocations = g_Allocations.load();
+		uint64_t bytes = g_AllocatedBytes.load();
+		Clock::time_point start = Clock::now();
+
+		c.body();
+
+		double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+		if( result.repetitions == 0 ){
+			result.allocsPerRun = g_Allocations.load() - allocations;
+			result.bytesPerTile = tiles ? ( double ) ( g_AllocatedBytes.load() - bytes ) / tiles : 0.0;
+			best = seconds;
+		}
+
+		best = std::min( best, seconds );
+		spent += seconds;
+		result.repetitions++;
+	} while( spent * 1000.0 < options.budget );
+
+	result.nsPerTile = tiles ? best * 1e9 / tiles : 0.0;
+	return result;
+}
+
+void Record( std::vector<Result> &results, Result result, const char *stage, const char *variant, int level, unsigned int threads ){
+	result.stage = stage;
+	result.variant = variant;
+	result.level = level;
+	result.threads = threads;
+	result.speedup = 1.0;
+
+	// Scaling against the single thread run of the same stage, which is measured first
+	for( const Result &other : results )
+		if( other.stage == result.stage && other.variant == result.variant && other.level == level && other.threads == 1 )
+			result.speedup = other.nsPerTile / result.nsPerTile;
+
+	results.push_back( result );
+	fprintf( stderr, "%-14s %-28s level %2d threads %2u %10.2f ns/tile\n", stage, variant, level, threads, result.nsPerTile );
+}
+
+void RunLevel( const Options &options, int level, std::vector<Result> &results ){
+	const Coordinate origin( 0.0, 0.0 );
+
+	// The tilling one level down, what deflate starts from
+	Penrose previous( std::max( level - 1, 0 ), origin, 36, 1.0f );
+	previous.execute();
+
+	Penrose base( level, origin, 36, 1.0f );
+	base.execute();
+	const size_t tiles = base.GetTriangles().size();
+
+	if( Enabled( options, "deflate" ) && level > 0 ){
+		Case c;
+		TriangleList<float> output;
+		c.body = [ & ](){ output = previous.deflate(); };
+		Record( results, Measure( options, c, tiles ), "deflate", "float", level, 1 );
+	}
+
+	if( Enabled( options, "execute" ) ){
+		std::unique_ptr<Penrose> p;
+		Case c;
+		c.setup = [ & ](){ p.reset( new Penrose( level, origin, 36, 1.0f ) ); };
+		c.body = [ & ](){ p->execute(); };
+		Record( results, Measure( options, c, tiles ), "execute", "float", level, 1 );
+
+		// Same run in an arena warmed by an earlier one, what regenerating in the application costs
+		Arena arena;
+		Penrose( level, origin, 36, 1.0f, &arena ).execute();
+		c.setup = [ & ](){
+			p.reset();
+			arena.Reset();
+			p.reset( new Penrose( level, origin, 36, 1.0f, &arena ) );
+		};
+		Record( results, Measure( options, c, tiles ), "execute", "float_arena", level, 1 );
+		p.reset();
+
+		// What the instanced draw builds instead: the DAG and the instances of its supertiles of half the depth
+		std::vector<TileInstance> instances;
+		Case dag;
+		dag.body = [ & ](){
+			SubstitutionDag substitution( level, CoordinateT<double>( 0.0, 0.0 ), 36, 1.0f );
+			for( int type = 1; type <= 2; type++ ){
+				instances.resize( ( size_t ) substitution.GetNumInstances( type, level / 2 ) );
+				substitution.ExpandInstances( type, level / 2, Span<TileInstance>( instances.data(), instances.size() ) );
+			}
+		};
+		Record( results, Measure( options, dag, tiles ), "execute", "dag_half_depth", level, 1 );
+	}
+
+	if( Enabled( options, "DoIt3D" ) ){
+		for( unsigned int threads : options.threads ){
+			std::unique_ptr<Penrose> p;
+			Case c;
+			c.setup = [ & ](){ p.reset(); p.reset( new Penrose( base ) ); };
+			c.body = [ & ](){ p->DoIt3D( 1.0f, ExtrusionApex::VertexA, threads ); };
+			Record( results, Measure( options, c, tiles * 4 ), "DoIt3D", "vertex_apex", level, threads );
+		}
+	}
+
+	if( Enabled( options, "GetVertices" ) ){
+		Penrose extruded( base );
+		extruded.DoIt3D();
+
+		struct Format{
+			const char *name;
+			VertexFormat format;
+			bool extruded;
+		};
+		const Format formats[] = {
+			{ "position", VertexFormat::Position, false },
+			{ "position_color", VertexFormat::PositionColor, false },
+			{ "position_texcoord", VertexFormat::PositionTexCoord, false },
+			{ "position_color_texcoord", VertexFormat::PositionColorTexCoord, false },
+			{ "position_color_texcoord_normal", VertexFormat::PositionColorTexCoordNormal, true },
+		};
+
+		// Written into a buffer of the caller, as when targeting a mapped GL buffer
+		for( const Format &format : formats ){
+			Penrose &p = format.extruded ? extruded : base;
+			std::vector<float> vertices( p.GetVertexFloats( format.format ) );
+			for( unsigned int threads : options.threads ){
+				Case c;
+				c.body = [ & ](){ p.WriteVertices( format.format, Span<float>( vertices.data(), vertices.size() ), threads ); };
+				Record( results, Measure( options, c, p.GetTriangles().size() ), "GetVertices", format.name, level, threads );
+			}
+		}
+
+		// The packed layouts of the renderer, next to the 48 byte position_color_texcoord_normal
+		auto measurePacked = [ & ]( auto tag, const char *name ){
+			typedef typename decltype( tag )::type Format;
+			std::vector<unsigned char> vertices( extruded.GetVertexBytes<Format>() );
+			for( unsigned int threads : options.threads ){
+				Case c;
+				c.body = [ & ](){ extruded.PackVertices<Format>( Span<unsigned char>( vertices.data(), vertices.size() ), threads ); };
+				Record( results, Measure( options, c, extruded.GetTriangles().size() ), "GetVertices", name, level, threads );
+			}
+		};
+		measurePacked( FormatTag<PackedFormat>(), "packed_24B" );
+		measurePacked( FormatTag<PackedHalfFormat>(), "packed_half_20B" );
+		measurePacked( FormatTag<TileFormat>(), "tile_16B" );
+		measurePacked( FormatTag<TileHalfFormat>(), "tile_half_8B" );
+
+		// What the instanced draw uploads instead: a TileInstance per tile of the flat tilling, by type
+		std::vector<TileInstance> instances( tiles );
+		Case c;
+		c.body = [ & ](){
+			size_t written = 0;
+			for( int type = 1; type <= 2; type++ )
+				written += base.WriteInstances( type, Span<TileInstance>( instances.data() + written, instances.size() - written ) );
+		};
+		Record( results, Measure( options, c, tiles ), "GetVertices", "instances_16B", level, 1 );
+	}
+
+	if( Enabled( options, "RotatePoint3D" ) ){
+		const TriangleList<float> &triangles = base.GetTriangles();
+		volatile float sink = 0.0f;
+		Case c;
+		c.body = [ & ](){
+			float sum = 0.0f;
+			for( const Triangle &t : triangles ){
+				sum += Coordinate::RotatePoint3D( origin, 36.0f, t.a, Axis::X ).z;
+				sum += Coordinate::RotatePoint3D( origin, 36.0f, t.b, Axis::X ).z;
+				sum += Coordinate::RotatePoint3D( origin, 36.0f, t.c, Axis::X ).z;
+			}
+			sink = sum;
+		};
+		Record( results, Measure( options, c, tiles ), "RotatePoint3D", "per_point", level, 1 );
+	}
+
+	if( Enabled( options, "Rotate" ) ){
+		const Rotation3D rotation( Axis::X, 36.0 );
+		for( unsigned int threads : options.threads ){
+			std::unique_ptr<Penrose> p;
+			Case c;
+			c.setup = [ & ](){ p.reset(); p.reset( new Penrose( base ) ); };
+			c.body = [ & ](){ p->Rotate( rotation, threads ); };
+			Record( results, Measure( options, c, tiles ), "Rotate", "batched", level, threads );
+		}
+	}
+}
+
+void WriteCsv( FILE *file, const std::vector<Result> &results ){
+	fprintf( file, "stage,variant,level,threads,tiles,repetitions,ns_per_tile,bytes_per_tile,allocs_per_run,speedup\n" );
+	for( const Result &r : results )
+		fprintf( file, "%s,%s,%d,%u,%zu,%d,%.3f,%.3f,%llu,%.3f\n", r.stage.c_str(), r.variant.c_str(), r.level, r.threads,
+			r.tiles, r.repetitions, r.nsPerTile, r.bytesPerTile, ( unsigned long long ) r.allocsPerRun, r.speedup );
+}
+
+void WriteJson( FILE *file, const std::vector<Result> &results ){
+	fprintf( file, "[\n" );
+	for( size_t i = 0; i < results.size(); i++ ){
+		const Result &r = results[ i ];
+		fprintf( file, "  { \"stage\": \"%s\", \"variant\": \"%s\", \"level\": %d, \"threads\": %u, \"tiles\": %zu, \"repetitions\": %d, "
+			"\"ns_per_tile\": %.3f, \"bytes_per_tile\": %.3f, \"allocs_per_run\": %llu, \"speedup\": %.3f }%s\n",
+			r.stage.c_str(), r.variant.c_str(), r.level, r.threads, r.tiles, r.repetitions, r.nsPerTile, r.bytesPerTile,
+			( unsigned long long ) r.allocsPerRun, r.speedup, i + 1 < results.size() ? "," : "" );
+	}
+	fprintf( file, "]\n" );
+}
+
+}
+
+int main( int argc, char **argv ){
+	Options options;
+	if( !ParseOptions( argc, argv, options ) ){
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<Result> results;
+	for( int level = options.minLevel; level <= options.maxLevel; level++ )
+		RunLevel( options, level, results );
+
+	FILE *file = options.out == "-" ? stdout : fopen( options.out.c_str(), "w" );
+	if( !file ){
+		fprintf( stderr, "Error: can't write %s\n", options.out.c_str() );
+		return 1;
+	}
+
+	if( options.format == "json" )
+		WriteJson( file, results );
+	else
+		WriteCsv( file, results );
+
+	if( file != stdout )
+		fclose( file );
+
+	return 0;
+}
@@ -0,0 +1,261 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "ImageWriter.h"
+#include "Parallel.h"
+#include "Penrose.h"
+#include "SoftwareRasterizer.h"
+
+/*
+ * Offline renderer of the explode animation, without a window or GL context.
+ * Every frame is rendered by the software rasterizer with the lights, model matrix and
+ * geometry stage of the application, frames are spread over the worker threads.
+ *
+ * Usage: PenroseRender [options]
+ *   --level N            Deflations of the tilling ( 3 )
+ *   --degree D           Angle of the seed triangles, 360 / D of them ( 36 )
+ *   --size WxH           Resolution of the frames ( 1280x720 )
+ *   --frames N           Frames to render ( 120 )
+ *   --fps N              Frame rate of the animation clock and the Y4M header ( 30 )
+ *   --magnitude M        Explotion magnitude, the uniform of the geometry stage ( 1 )
+ *   --camera PATH        static, orbit, dolly or a file with one "x y z" keyframe per line ( static )
+ *   --out DIR            Directory for numbered frames, frame_00000.png ... ( frames )
+ *   --format F           png, ppm or y4m, y4m writes DIR/penrose.y4m or stdout with --out - ( png )
+ *   --textures DIR       Directory with nether_brick.png and amatista_block.png ( res/textures )
+ *   --threads N          Worker threads, 0 for one per hardware thread ( 0 )
+ */
+
+namespace{
+
+typedef std::chrono::steady_clock Clock;
+
+double SecondsSince( Clock::time_point start ){
+	return std::chrono::duration<double>( Clock::now() - start ).count();
+}
+
+struct Options{
+	int level = 3;
+	int degree = 36;
+	int width = 1280;
+	int height = 720;
+	int frames = 120;
+	int fps = 30;
+	float magnitude = 1.0f;
+	std::string camera = "static";
+	std::string out = "frames";
+	std::string format = "png";
+	std::string textures = "res/textures";
+	unsigned int threads = 0;
+};
+
+void PrintUsage(){
+	fprintf( stderr, "Usage: PenroseRender [--level N] [--degree D] [--size WxH] [--frames N] [--fps N] [--magnitude M]\n"
+		"                     [--camera static|orbit|dolly|FILE] [--out DIR] [--format png|ppm|y4m]\n"
+		"                     [--textures DIR] [--threads N]\n" );
+}
+
+// @return false when an option is unknown or lacks its value
+bool ParseOptions( int argc, char **argv, Options &options ){
+	for( int i = 1; i < argc; i++ ){
+		std::string name = argv[ i ];
+		if( i + 1 >= argc )
+			return false;
+		const char *value = argv[ ++i ];
+
+		if( name == "--level" ){
+			options.level = atoi( value );
+		} else if( name == "--degree" ){
+			options.degree = atoi( value );
+		} else if( name == "--size" ){
+			if( sscanf( value, "%dx%d", &options.width, &options.height ) != 2 )
+				return false;
+		} else if( name == "--frames" ){
+			options.frames = atoi( value );
+		} else if( name == "--fps" ){
+			options.fps = atoi( value );
+		} else if( name == "--magnitude" ){
+			options.magnitude = ( float ) atof( value );
+		} else if( name == "--camera" ){
+			options.camera = value;
+		} else if( name == "--out" ){
+			options.out = value;
+		} else if( name == "--format" ){
+			options.format = value;
+		} else if( name == "--textures" ){
+			options.textures = value;
+		} else if( name == "--threads" ){
+			options.threads = ( unsigned int ) atoi( value );
+		} else{
+			return false;
+		}
+	}
+
+	return options.width > 0 && options.height > 0 && options.frames > 0 && options.fps > 0 &&
+		( options.format == "png" || options.format == "ppm" || options.format == "y4m" );
+}
+
+// Camera position of every frame, the camera always looks at the center of the tilling
+class CameraPath{
+private:
+	std::vector<glm::vec3> m_Keyframes;
+
+public:
+	// @return false if name isn't a known path and can't be read as a keyframe file
+	bool Load( const std::string &name ){
+		if( name == "static" ){
+			// Where the application camera starts
+			m_Keyframes = { glm::vec3( 0.0f, 0.0f, 3.0f ) };
+		} else if( name == "orbit" ){
+			for( int i = 0; i <= 64; i++ ){
+				float angle = glm::radians( 360.0f * i / 64.0f );
+				m_Keyframes.push_back( glm::vec3( 3.0f * sinf( angle ), 1.0f, 3.0f * cosf( angle ) ) );
+			}
+		} else if( name == "dolly" ){
+			m_Keyframes = { glm::vec3( 0.0f, 0.0f, 4.0f ), glm::vec3( 0.0f, 0.0f, 1.5f ) };
+		} else{
+			std::ifstream stream( name );
+			std::string line;
+			while( std::getline( stream, line ) ){
+				std::stringstream ss( line );
+				glm::vec3 position;
+				if( ss >> position.x >> position.y >> position.z )
+					m_Keyframes.push_back( position );
+			}
+		}
+
+		return !m_Keyframes.empty();
+	}
+
+	// @param t: 0 for the first frame, 1 for the last one
+	glm::vec3 Position( float t ) const{
+		if( m_Keyframes.size() == 1 )
+			return m_Keyframes[ 0 ];
+
+		float at = glm::clamp( t, 0.0f, 1.0f ) * ( m_Keyframes.size() - 1 );
+		size_t index = std::min( ( size_t ) at, m_Keyframes.size() - 2 );
+		return glm::mix( m_Keyframes[ index ], m_Keyframes[ index + 1 ], at - index );
+	}
+};
+
+}
+
+int main( int argc, char **argv ){
+	Options options;
+	if( !ParseOptions( argc, argv, options ) ){
+		PrintUsage();
+		return 1;
+	}
+
+	CameraPath path;
+	if( !path.Load( options.camera ) ){
+		fprintf( stderr, "Error: unknown camera path %s\n", options.camera.c_str() );
+		return 1;
+	}
+
+	Clock::time_point start = Clock::now();
+	Penrose p( options.level, Coordinate( 0.0, 0.0 ), options.degree, 1.0f );
+	p.execute();
+	p.DoIt3D();
+	std::unique_ptr<float[]> vertices( p.GetVerticesWithColorsTexCoordsAndNormalLight() );
+	double generate = SecondsSince( start );
+
+	VertexStream stream;
+	stream.data = vertices.get();
+	stream.vertexCount = ( size_t ) p.GetNumTriangles() * 3;
+
+	// Same units as the application: 1 is amatista, 2 is nether brick
+	RasterTexture textures[ 2 ];
+	textures[ 0 ].Load( options.textures + "/amatista_block.png" );
+	textures[ 1 ].Load( options.textures + "/nether_brick.png" );
+
+	// Model matrix and projection of the application, with a near plane in front of the tilling
+	glm::mat4 model = glm::scale( glm::mat4( 1.0f ), glm::vec3( 1.0f, 1.0f, 0.5f ) );
+	glm::mat4 projection = glm::perspective( glm::radians( 45.0f ), ( float ) options.width / ( float ) options.height, 0.1f, 100.0f );
+
+	if( options.out != "-" ){
+		std::error_code error;
+		std::filesystem::create_directories( options.out, error );
+	}
+
+	std::unique_ptr<Y4MWriter> y4m;
+	if( options.format == "y4m" ){
+		y4m.reset( new Y4MWriter( options.out == "-" ? "-" : options.out + "/penrose.y4m", options.width, options.height, options.fps ) );
+		if( !y4m->IsOpen() ){
+			fprintf( stderr, "Error: can't write to %s\n", options.out.c_str() );
+			return 1;
+		}
+	}
+
+	// Frames are rendered in batches of one frame per worker, each worker with its own single threaded rasterizer.
+	// The Y4M stream is written in order after every batch.
+	unsigned int workers = ParallelChunks( options.frames, options.threads );
+	std::vector<std::unique_ptr<SoftwareRasterizer>> rasterizers( workers );
+	for( std::unique_ptr<SoftwareRasterizer> &rasterizer : rasterizers ){
+		rasterizer.reset( new SoftwareRasterizer( options.width, options.height, 64, 1 ) );
+		rasterizer->SetTexture( 1, &textures[ 0 ] );
+		rasterizer->SetTexture( 2, &textures[ 1 ] );
+	}
+
+	std::atomic<bool> failed( false );
+	start = Clock::now();
+
+	for( int first = 0; first < options.frames; first += workers ){
+		int batch = std::min<int>( workers, options.frames - first );
+
+		ParallelFor( batch, batch, [ & ]( size_t, size_t, unsigned int worker ){
+			int frame = first + ( int ) worker;
+			SoftwareRasterizer &rasterizer = *rasterizers[ worker ];
+
+			float t = options.frames > 1 ? ( float ) frame / ( options.frames - 1 ) : 0.0f;
+			glm::vec3 position = path.Position( t );
+			glm::vec3 front = glm::normalize( -position );
+			glm::vec3 up = fabsf( front.y ) > 0.99f ? glm::vec3( 0.0f, 0.0f, -1.0f ) : glm::vec3( 0.0f, 1.0f, 0.0f );
+			glm::mat4 view = glm::lookAt( position, glm::vec3( 0.0f ), up );
+
+			// The animation clock of the application, glfwGetTime, at the frame rate of the clip
+			ExplodeParams explode;
+			explode.time = ( float ) frame / options.fps;
+			explode.magnitude = options.magnitude;
+
+			rasterizer.Clear( glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+			rasterizer.Draw( stream, model, view, projection, SceneLights::Default( position, front ), explode );
+
+			if( !y4m ){
+				char name[ 32 ];
+				snprintf( name, sizeof( name ), "/frame_%05d.%s", frame, options.format.c_str() );
+				if( !rasterizer.Write( options.out + name ) )
+					failed = true;
+			}
+		} );
+
+		if( y4m ){
+			for( int i = 0; i < batch; i++ )
+				if( !y4m->WriteFrame( rasterizers[ i ]->GetColor().data() ) )
+					failed = true;
+		}
+
+		if( failed ){
+			fprintf( stderr, "Error: can't write frames to %s\n", options.out.c_str() );
+			return 1;
+		}
+	}
+
+	double render = SecondsSince( start );
+
+	fprintf( stderr, "triangles: %d, generation: %.3f s\n", p.GetNumTriangles(), generate );
+	fprintf( stderr, "frames: %d at %dx%d with %u threads in %.3f s, %.2f frames/s, %.2f ms/frame, %.2f Mtri/s\n",
+		options.frames, options.width, options.height, workers, render, options.frames / render,
+		render * 1000.0 / options.frames, ( double ) p.GetNumTriangles() * options.frames / render / 1e6 );
+
+	return 0;
+}
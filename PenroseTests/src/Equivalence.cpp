@@ -0,0 +1,443 @@
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Arena.h"
+#include "Penrose.h"
+#include "PenroseStats.h"
+#include "SoftwareRasterizer.h"
+#include "SubstitutionDag.h"
+#include "VertexFormats.h"
+
+/*
+ * Checks that the different ways of building and serialising a tilling agree, run by ctest:
+ *   - the tiles placed by the instances of SubstitutionDag are the tiles of the executed Penrose,
+ *     with instances of single tiles and of supertiles drawn from a deflated prototype
+ *   - WriteVertices split between threads writes the same floats as WriteVerticesTo on one
+ *   - the packed formats decode to the float format within the precision of their types
+ *   - FloatToHalf, PackUnorm and PackSnorm give back every code of their types once decoded
+ *   - SoftwareRasterizer lights with the normals project.shader has under a non uniform scale
+ *   - PenroseStats::Analytic counts what Measure finds in the generated tillings, BigUInt holds the
+ *     counts of hundreds of levels, and the vertex configurations don't depend on the threads
+ *
+ * Usage: PenroseTests [level]
+ *   level                Deflations of the largest tilling compared ( 7 )
+ *
+ * Every check that fails is printed and the exit code is 1 if any did.
+ */
+
+namespace{
+
+int g_Failures = 0;
+
+void Check( bool ok, const char *format, ... ){
+	if( ok )
+		return;
+	g_Failures++;
+
+	va_list args;
+	va_start( args, format );
+	fprintf( stderr, "FAILED: " );
+	vfprintf( stderr, format, args );
+	fprintf( stderr, "\n" );
+	va_end( args );
+}
+
+// Of a vertex of the tilling, of diameter 1, placed in double from the float instances
+const double PLACEMENT_TOLERANCE = 1e-5;
+
+struct Tile{
+	int type;
+	glm::dvec2 corners[ 3 ];
+};
+
+// Same as PlaceTile in project.shader
+glm::dvec2 Place( const TileInstance &instance, glm::dvec2 position ){
+	if( instance.scale < 0.0f )
+		position.y = -position.y;
+	position *= std::abs( ( double ) instance.scale );
+	double c = cos( ( double ) instance.rotation ), s = sin( ( double ) instance.rotation );
+	return glm::dvec2( instance.x + c * position.x - s * position.y, instance.y + s * position.x + c * position.y );
+}
+
+std::vector<Tile> TilesOf( const Penrose &tilling ){
+	std::vector<Tile> tiles;
+	tiles.reserve( tilling.GetNumTriangles() );
+	for( const Triangle &t : tilling.GetTriangles() )
+		tiles.push_back( { t.type, { glm::dvec2( t.a.x, t.a.y ), glm::dvec2( t.b.x, t.b.y ), glm::dvec2( t.c.x, t.c.y ) } } );
+	return tiles;
+}
+
+// @return the tiles of the DAG drawn the way InstancedTilling does, the mesh of each supertile of depth at every instance
+std::vector<Tile> TilesOf( const SubstitutionDag &dag, int depth, Arena &arena ){
+	std::vector<Tile> tiles;
+	for( int type = 1; type <= 2; type++ ){
+		std::vector<TileInstance> instances( dag.GetNumInstances( type, depth ) );
+		size_t written = dag.ExpandInstances( type, depth, Span<TileInstance>( instances.data(), instances.size() ) );
+		Check( written == instances.size(), "dag depth %d type %d: %zu instances written of %zu", depth, type, written, instances.size() );
+
+		Penrose prototype( Triangle::Prototype( type ), depth, &arena );
+		prototype.execute();
+		for( const TileInstance &instance : instances ){
+			for( const Triangle &t : prototype.GetTriangles() ){
+				tiles.push_back( { t.type, {
+					Place( instance, glm::dvec2( t.a.x, t.a.y ) ),
+					Place( instance, glm::dvec2( t.b.x, t.b.y ) ),
+					Place( instance, glm::dvec2( t.c.x, t.c.y ) ) } } );
+			}
+		}
+	}
+	return tiles;
+}
+
+bool SameTile( const Tile &a, const Tile &b ){
+	if( a.type != b.type )
+		return false;
+	for( int k = 0; k < 3; k++ )
+		if( glm::length( a.corners[ k ] - b.corners[ k ] ) > PLACEMENT_TOLERANCE )
+			return false;
+	return true;
+}
+
+/**
+ * Match every tile of expected with one of actual, by the cell of corner a and the ones around it
+ *
+ * @return the tiles of expected without a match
+ */
+size_t Unmatched( const std::vector<Tile> &expected, const std::vector<Tile> &actual ){
+	const double CELL = 1e-3;
+	auto cellOf = [ & ]( glm::dvec2 p, int dx, int dy ){
+		int64_t x = ( int64_t ) floor( p.x / CELL ) + dx, y = ( int64_t ) floor( p.y / CELL ) + dy;
+		return ( uint64_t ) x * 0x9E3779B97F4A7C15ull ^ ( uint64_t ) y;
+	};
+
+	std::unordered_multimap<uint64_t, size_t> cells;
+	for( size_t i = 0; i < actual.size(); i++ )
+		cells.emplace( cellOf( actual[ i ].corners[ 0 ], 0, 0 ), i );
+
+	std::vector<bool> used( actual.size(), false );
+	size_t unmatched = 0;
+	for( const Tile &tile : expected ){
+		bool found = false;
+		for( int dy = -1; dy <= 1 && !found; dy++ ){
+			for( int dx = -1; dx <= 1 && !found; dx++ ){
+				auto range = cells.equal_range( cellOf( tile.corners[ 0 ], dx, dy ) );
+				for( auto it = range.first; it != range.second && !found; ++it ){
+					if( !used[ it->second ] && SameTile( tile, actual[ it->second ] ) ){
+						used[ it->second ] = true;
+						found = true;
+					}
+				}
+			}
+		}
+		unmatched += !found;
+	}
+	return unmatched;
+}
+
+void CheckDagMatchesPenrose( int maxLevel, Arena &arena ){
+	for( int level = 0; level <= maxLevel; level++ ){
+		Penrose tilling( level, Coordinate( 0.0f, 0.0f ), 36, 1.0f, &arena );
+		tilling.execute();
+		std::vector<Tile> expected = TilesOf( tilling );
+
+		SubstitutionDag dag( level, CoordinateT<double>( 0.0, 0.0 ), 36, 1.0f );
+		Check( dag.GetNumTiles() == expected.size(), "dag level %d: %llu tiles, Penrose has %zu",
+			level, ( unsigned long long ) dag.GetNumTiles(), expected.size() );
+
+		// Single tiles, supertiles of half the levels and the whole seeds
+		const int depths[] = { 0, level / 2, level };
+		for( int depth : depths ){
+			std::vector<Tile> actual = TilesOf( dag, depth, arena );
+			Check( actual.size() == expected.size(), "dag level %d depth %d: %zu tiles placed, Penrose has %zu",
+				level, depth, actual.size(), expected.size() );
+			size_t unmatched = Unmatched( expected, actual );
+			Check( unmatched == 0, "dag level %d depth %d: %zu tiles of Penrose not placed by the instances", level, depth, unmatched );
+		}
+		arena.Reset();
+	}
+}
+
+template<typename Format>
+void CheckWritersAgree( const Penrose &tilling, const char *name ){
+	std::vector<float> serial;
+	serial.reserve( tilling.GetVertexFloats<Format>() );
+	tilling.WriteVerticesTo<Format>( std::back_inserter( serial ) );
+
+	const unsigned int threads[] = { 1, 3, 8 };
+	for( unsigned int count : threads ){
+		std::vector<float> parallel( tilling.GetVertexFloats<Format>() );
+		size_t written = tilling.WriteVertices<Format>( Span<float>( parallel.data(), parallel.size() ), count );
+		Check( written == serial.size() && memcmp( parallel.data(), serial.data(), serial.size() * sizeof( float ) ) == 0,
+			"%s: WriteVertices on %u threads differs from WriteVerticesTo", name, count );
+	}
+}
+
+// Decoders as GL reads the packed types
+float HalfToFloat( uint16_t half ){
+	int exponent = ( half >> 10 ) & 0x1f;
+	int mantissa = half & 0x3ff;
+	float value;
+	if( exponent == 0 )
+		value = std::ldexp( ( float ) mantissa, -24 );
+	else if( exponent == 31 )
+		value = mantissa ? NAN : INFINITY;
+	else
+		value = std::ldexp( ( float ) ( mantissa | 0x400 ), exponent - 25 );
+	return half & 0x8000 ? -value : value;
+}
+
+float SnormToFloat( int32_t value, float max ){
+	return std::max( value / max, -1.0f );
+}
+
+// @return the 10 bit component at shift of a GL_INT_2_10_10_10_REV, sign extended
+int32_t Component10( uint32_t packed, int shift ){
+	int32_t value = ( int32_t ) ( ( packed >> shift ) & 0x3ff );
+	return value >= 512 ? value - 1024 : value;
+}
+
+void CheckEncoders(){
+	// Every finite half, both zeros included
+	for( uint32_t half = 0; half < 0x10000; half++ ){
+		float value = HalfToFloat( ( uint16_t ) half );
+		if( std::isnan( value ) )
+			continue;
+		uint16_t back = FloatToHalf( value );
+		Check( back == half, "FloatToHalf( %g ) is 0x%04x, not 0x%04x", value, back, half );
+	}
+	// Halfway between two halves goes to the even one, past the largest to infinity
+	Check( FloatToHalf( 1.0f + std::ldexp( 1.0f, -11 ) ) == 0x3c00, "FloatToHalf doesn't round ties to even" );
+	Check( FloatToHalf( 1.0f + 3.0f * std::ldexp( 1.0f, -11 ) ) == 0x3c02, "FloatToHalf doesn't round ties to even" );
+	Check( FloatToHalf( 65520.0f ) == 0x7c00, "FloatToHalf( 65520 ) doesn't overflow to infinity" );
+
+	for( uint32_t code = 0; code <= 255; code++ )
+		Check( PackUnorm( code / 255.0f, 255.0f ) == code, "PackUnorm of 8 bits doesn't give back %u", code );
+	for( uint32_t code = 0; code <= 65535; code++ )
+		Check( PackUnorm( code / 65535.0f, 65535.0f ) == code, "PackUnorm of 16 bits doesn't give back %u", code );
+	for( int32_t code = -511; code <= 511; code++ )
+		Check( PackSnorm( code / 511.0f, 511.0f ) == code, "PackSnorm of 10 bits doesn't give back %d", code );
+}
+
+/**
+ * Decode every vertex of a packed format and compare it with the float format of the same tilling
+ *
+ * @param positionTolerance: Relative, 0 for the float positions
+ */
+template<typename Format>
+void CheckPackedRoundTrip( const Penrose &tilling, const char *name, float positionTolerance ){
+	typedef PositionColorTexCoordNormalFormat Reference;
+	std::vector<float> reference( tilling.GetVertexFloats<Reference>() );
+	tilling.WriteVertices<Reference>( Span<float>( reference.data(), reference.size() ), 1 );
+
+	std::vector<unsigned char> packed( tilling.GetVertexBytes<Format>() );
+	size_t written = tilling.PackVertices<Format>( Span<unsigned char>( packed.data(), packed.size() ), 1 );
+	Check( written == packed.size(), "%s: %zu bytes packed of %zu", name, written, packed.size() );
+
+	const size_t stride = VertexStride<Format>();
+	const size_t floats = VertexStride<Reference>() / sizeof( float );
+	const size_t vertices = packed.size() / stride;
+	// The error bound of each type, half a step of the integer ones
+	const float UNORM8 = 0.5f / 255.0f + 1e-6f;
+	const float SNORM10 = 0.5f / 511.0f + 1e-6f;
+
+	size_t failures = 0;
+	for( size_t v = 0; v < vertices && failures < 10; v++ ){
+		const unsigned char *vertex = packed.data() + v * stride;
+		const float *expected = reference.data() + v * floats;
+		glm::vec3 position( expected[ 0 ], expected[ 1 ], expected[ 2 ] );
+		glm::vec3 color( expected[ 3 ], expected[ 4 ], expected[ 5 ] );
+		glm::vec2 texCoord( expected[ 6 ], expected[ 7 ] );
+		float texIndex = expected[ 8 ];
+		glm::vec3 normal( expected[ 9 ], expected[ 10 ], expected[ 11 ] );
+
+		bool ok = true;
+		for( size_t i = 0; i < std::size( Format::ATTRIBUTES ); i++ ){
+			const VertexAttribute &attribute = Format::ATTRIBUTES[ i ];
+			const unsigned char *in = vertex + AttributeOffset<Format>( i );
+
+			if( attribute.semantic == VertexSemantic::Position ){
+				for( int k = 0; k < 3; k++ ){
+					float value;
+					if( attribute.type == AttributeType::HalfFloat ){
+						uint16_t half;
+						memcpy( &half, in + k * 2, 2 );
+						value = HalfToFloat( half );
+					} else
+						memcpy( &value, in + k * 4, 4 );
+					ok = ok && std::abs( value - position[ k ] ) <= positionTolerance * std::max( std::abs( position[ k ] ), 1.0f );
+				}
+			} else if( attribute.semantic == VertexSemantic::Normal ){
+				uint32_t bits;
+				memcpy( &bits, in, 4 );
+				for( int k = 0; k < 3; k++ )
+					ok = ok && std::abs( SnormToFloat( Component10( bits, k * 10 ), 511.0f ) - normal[ k ] ) <= SNORM10;
+			} else if( attribute.semantic == VertexSemantic::Color ){
+				for( int k = 0; k < 3; k++ )
+					ok = ok && std::abs( in[ k ] / 255.0f - color[ k ] ) <= UNORM8;
+				ok = ok && in[ 3 ] == 255;
+			} else if( attribute.semantic == VertexSemantic::TexCoord ){
+				// Approximate, the 0.5 of the apex is 128 / 255
+				for( int k = 0; k < 2; k++ )
+					ok = ok && std::abs( in[ k ] / 255.0f - texCoord[ k ] ) <= UNORM8;
+			} else if( attribute.semantic == VertexSemantic::TexIndex ){
+				ok = ok && in[ 0 ] == texIndex;
+			}
+		}
+
+		if( !ok ){
+			failures++;
+			Check( false, "%s: vertex %zu doesn't decode to the float format", name, v );
+		}
+	}
+}
+
+/*
+ * A triangle tilted out of the plane under the ( 1, 1, 0.5 ) scale of PenroseRender, lit by a white
+ * directional light only: the pixel is the diffuse term, the cosine between the light and the normal.
+ * The normal of the stream is in object space, project.shader takes it to world space with the inverse
+ * transpose of the model, which is also the normal of the triangle once scaled.
+ */
+void CheckRasterizerNormals(){
+	const glm::vec3 corners[ 3 ] = { glm::vec3( -1.0f, -1.0f, 0.0f ), glm::vec3( 1.0f, -1.0f, 0.0f ), glm::vec3( 0.0f, 1.0f, 2.0f ) };
+	const glm::mat4 model = glm::scale( glm::mat4( 1.0f ), glm::vec3( 1.0f, 1.0f, 0.5f ) );
+	const glm::vec3 objectNormal = glm::normalize( glm::cross( corners[ 1 ] - corners[ 0 ], corners[ 2 ] - corners[ 0 ] ) );
+
+	float vertices[ 3 * 12 ] = {};
+	for( int k = 0; k < 3; k++ ){
+		float *vertex = vertices + k * 12;
+		for( int i = 0; i < 3; i++ ){
+			vertex[ i ] = corners[ k ][ i ];
+			vertex[ 9 + i ] = objectNormal[ i ];
+		}
+	}
+	VertexStream stream;
+	stream.data = vertices;
+	stream.vertexCount = 3;
+
+	// Nothing but the diffuse of the directional light, the other lights are black but mustn't give NaN
+	SceneLights lights = SceneLights();
+	lights.viewPos = glm::vec3( 0.0f, 0.0f, 5.0f );
+	lights.material.shininess = 1.0f;
+	lights.dirLight.direction = glm::vec3( 0.0f, 0.0f, -1.0f );
+	lights.dirLight.diffuse = glm::vec3( 1.0f );
+	for( PointLight &light : lights.pointLights )
+		light.constant = 1.0f;
+	lights.spotLight.constant = 1.0f;
+	lights.spotLight.direction = glm::vec3( 0.0f, 0.0f, -1.0f );
+	lights.spotLight.cutOff = 1.0f;
+	lights.spotLight.outerCutOff = 0.5f;
+
+	RasterTexture white;
+	white.width = white.height = 1;
+	white.pixels.assign( 4, 255 );
+
+	const int SIZE = 64;
+	SoftwareRasterizer rasterizer( SIZE, SIZE, 16, 2 );
+	rasterizer.SetTexture( 0, &white );
+	rasterizer.Draw( stream, model, glm::lookAt( lights.viewPos, glm::vec3( 0.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) ),
+		glm::ortho( -2.0f, 2.0f, -2.0f, 2.0f, 0.1f, 10.0f ), lights );
+
+	const glm::vec3 shaderNormal = glm::normalize( glm::transpose( glm::inverse( glm::mat3( model ) ) ) * objectNormal );
+	const glm::vec3 world[ 3 ] = { glm::vec3( model * glm::vec4( corners[ 0 ], 1.0f ) ), glm::vec3( model * glm::vec4( corners[ 1 ], 1.0f ) ),
+		glm::vec3( model * glm::vec4( corners[ 2 ], 1.0f ) ) };
+	const glm::vec3 faceNormal = glm::normalize( glm::cross( world[ 1 ] - world[ 0 ], world[ 2 ] - world[ 0 ] ) );
+	Check( glm::length( shaderNormal - faceNormal ) < 1e-5f, "the normal matrix doesn't give the normal of the scaled triangle" );
+
+	float expected = std::max( shaderNormal.z, 0.0f );
+	const uint8_t *center = &rasterizer.GetColor()[ ( ( size_t ) ( SIZE / 2 ) * SIZE + SIZE / 2 ) * 4 ];
+	Check( std::abs( center[ 0 ] / 255.0f - expected ) <= 1.0f / 255.0f, "rasterizer lights the scaled triangle with %.3f, project.shader with %.3f",
+		center[ 0 ] / 255.0f, expected );
+}
+
+void CheckAnalyticMatchesMeasure( int maxLevel, Arena &arena ){
+	const int SEEDS = 10;
+	std::vector<LevelStats> analytic = PenroseStats::Analytic( maxLevel, BigUInt( SEEDS ), BigUInt( 0 ), 1.0 );
+	Check( analytic.size() == ( size_t ) maxLevel + 1, "Analytic gave %zu levels of %d", analytic.size(), maxLevel + 1 );
+
+	for( int level = 0; level <= maxLevel && level < ( int ) analytic.size(); level++ ){
+		PenroseT<double> tilling( level, CoordinateT<double>( 0.0, 0.0 ), 360 / SEEDS, 1.0f, &arena );
+		tilling.execute();
+		GeometricStats measured = PenroseStats::Measure( tilling.GetTriangles(), 2 );
+		const LevelStats &expected = analytic[ level ];
+
+		Check( expected.thinTriangles.ToUInt64() == measured.thinTriangles && expected.thickTriangles.ToUInt64() == measured.thickTriangles,
+			"stats level %d: Analytic has %s thin and %s thick, Measure %llu and %llu", level, expected.thinTriangles.ToString().c_str(),
+			expected.thickTriangles.ToString().c_str(), ( unsigned long long ) measured.thinTriangles, ( unsigned long long ) measured.thickTriangles );
+		Check( std::abs( ( double ) expected.thinArea - measured.thinArea ) < 1e-9 && std::abs( ( double ) expected.thickArea - measured.thickArea ) < 1e-9,
+			"stats level %d: Analytic areas %.12f and %.12f, Measure %.12f and %.12f", level,
+			( double ) expected.thinArea, ( double ) expected.thickArea, measured.thinArea, measured.thickArea );
+		arena.Reset();
+	}
+}
+
+void CheckBigCounts(){
+	// From 10 thin triangles level n has 10 F( 2n - 1 ) thin and 10 F( 2n ) thick, F the Fibonacci numbers
+	const int LEVEL = 200;
+	std::vector<LevelStats> analytic = PenroseStats::Analytic( LEVEL, BigUInt( 10 ), BigUInt( 0 ), 1.0 );
+	const LevelStats &stats = analytic.back();
+	const char *THIN = "1087886174634756452897619922890497448449957054778126990997512027493939263598163042260";
+	const char *THICK = "1760236806450139664682269453924112507703843833044921918867259928965753450442160196750";
+
+	Check( !stats.thickTriangles.FitsUInt64(), "stats level %d: the thick count fits 64 bits", LEVEL );
+	Check( stats.thinTriangles.ToString() == THIN, "stats level %d: %s thin triangles, not 10 F( 399 )", LEVEL, stats.thinTriangles.ToString().c_str() );
+	Check( stats.thickTriangles.ToString() == THICK, "stats level %d: %s thick triangles, not 10 F( 400 )", LEVEL, stats.thickTriangles.ToString().c_str() );
+	Check( stats.totalTriangles == stats.thinTriangles + stats.thickTriangles, "stats level %d: total isn't thin + thick", LEVEL );
+
+	const long double GOLDEN_RATIO = ( 1.0L + std::sqrt( 5.0L ) ) / 2.0L;
+	Check( std::abs( stats.thickThinRatio - GOLDEN_RATIO ) < 1e-15L, "stats level %d: thick / thin is %.18Lf, not the golden ratio", LEVEL, stats.thickThinRatio );
+}
+
+void CheckConfigurationsAcrossThreads( const Penrose &tilling ){
+	GeometricStats reference = PenroseStats::Measure( tilling.GetTriangles(), 1 );
+	uint64_t total = 0;
+	for( const auto &configuration : reference.vertexConfigurations )
+		total += configuration.second;
+	Check( total == reference.interiorVertices, "stats: %llu vertices in the configurations of %llu interior ones",
+		( unsigned long long ) total, ( unsigned long long ) reference.interiorVertices );
+
+	const unsigned int threads[] = { 2, 3, 8 };
+	for( unsigned int count : threads ){
+		GeometricStats stats = PenroseStats::Measure( tilling.GetTriangles(), count );
+		Check( stats.vertexConfigurations == reference.vertexConfigurations && stats.interiorVertices == reference.interiorVertices &&
+			stats.boundaryVertices == reference.boundaryVertices, "stats: the vertices measured on %u threads differ from 1 thread", count );
+	}
+}
+
+}
+
+int main( int argc, char **argv ){
+	int level = argc > 1 ? atoi( argv[ 1 ] ) : 7;
+	Arena arena;
+
+	CheckDagMatchesPenrose( level, arena );
+	CheckAnalyticMatchesMeasure( level, arena );
+	CheckBigCounts();
+
+	Penrose tilling( level, Coordinate( 0.0f, 0.0f ), 36, 1.0f, &arena );
+	tilling.execute();
+	CheckConfigurationsAcrossThreads( tilling );
+	CheckWritersAgree<PositionColorTexCoordFormat>( tilling, "flat PositionColorTexCoordFormat" );
+	tilling.DoIt3D( 1.0f );
+	CheckWritersAgree<PositionColorTexCoordNormalFormat>( tilling, "extruded PositionColorTexCoordNormalFormat" );
+
+	CheckEncoders();
+	CheckPackedRoundTrip<PackedFormat>( tilling, "PackedFormat", 0.0f );
+	// 11 bits of mantissa
+	CheckPackedRoundTrip<PackedHalfFormat>( tilling, "PackedHalfFormat", std::ldexp( 1.0f, -11 ) );
+
+	CheckRasterizerNormals();
+
+	if( g_Failures ){
+		fprintf( stderr, "%d checks failed\n", g_Failures );
+		return 1;
+	}
+	printf( "All checks passed up to level %d\n", level );
+	return 0;
+}
@@ -1,36 +1,78 @@
 #shader vertex
 #version 410 core
 
-layout( location = 0 ) in vec3 aPos;   // the position variable has attribute position 0
-layout( location = 1 ) in vec3 o_Color; // the color variable has attribute position 1
-layout( location = 2 ) in vec2 texCoord; // the texture variable has attribute position 2
-layout( location = 3 ) in float o_TexIndex; // the texture index variable has attribute psition 3
-layout( location = 4 ) in vec3 aNormal; // the normal light variable has attribute psition 4
+// The inputs ( aPos, o_Color, texCoord, o_TexIndex, aNormal, a_Tile or a_Instance ) and a HAS_<SEMANTIC>
+// define for each one are declared by the application from its vertex format, see VertexFormats.h. The
+// other stages get the HAS_<SEMANTIC> defines too
 
 out  VS_OUT{
     vec2 ourTexture; // output a texture to the fragment shader
     float v_TexIndex;
     vec3 v_Color;
-    vec3 v_Normal;
     vec3 v_FragPos;
+#ifdef HAS_NORMAL
+    vec3 v_Normal;
+#endif
 } vs_out;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// std140 blocks filled from the structs of UniformBlocks.h, through the UniformBuffer at the binding of each one
+layout( std140 ) uniform CameraBlock{
+    mat4 projection;
+    mat4 view;
+    mat4 model;
+    vec3 viewPos;
+};
+
+#ifdef HAS_TILE
+// Same as TriangleT::TEX_COORDS, by corner of the triangle
+const vec2 TEX_COORDS[ 3 ] = vec2[ 3 ]( vec2( 0.0, 0.0 ), vec2( 1.0, 0.0 ), vec2( 0.5, 1.0 ) );
+#endif
+
+#ifdef HAS_INSTANCE
+// aPos is on the prototype of the tile, a_Instance is the TileInstance that places it: corner a, angle of ab
+// and its length, negative for a mirrored tile. The height of an extruded prototype isn't scaled
+vec3 PlaceTile( vec3 position ){
+    if( a_Instance.w < 0.0 )
+        position.yz = -position.yz;
+    vec2 scaled = position.xy * abs( a_Instance.w );
+    float c = cos( a_Instance.z );
+    float s = sin( a_Instance.z );
+    return vec3( a_Instance.xy + vec2( c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y ), position.z );
+}
+#endif
 
 void main(){
+#ifdef HAS_INSTANCE
+    vs_out.v_FragPos = vec3( model * vec4( PlaceTile( aPos ), 1.0 ) );
+#else
     vs_out.v_FragPos = vec3( model * vec4( aPos, 1.0 ) );
+#endif
     gl_Position = projection * view * vec4( vs_out.v_FragPos, 1.0 );
+#ifdef HAS_NORMAL
+    // In world space like v_FragPos, the inverse transpose keeps it normal under a non uniform scale
+    vs_out.v_Normal = normalize( transpose( inverse( mat3( model ) ) ) * aNormal );
+#endif
+#ifdef HAS_TILE
+    // Only the position is stored, the rest follows from the type of the tile and the corner
+    int type = int( a_Tile ) & 3;
+    vs_out.ourTexture = TEX_COORDS[ gl_VertexID % 3 ];
+    vs_out.v_TexIndex = float( type );
+    vs_out.v_Color = vec3( 0.7 );
+#else
     vs_out.ourTexture = texCoord; // set ourColor to the input color we got from the vertex data
     vs_out.v_TexIndex = o_TexIndex;
     vs_out.v_Color = o_Color;
-    vs_out.v_Normal = aNormal;
+#endif
 }
 
 
 #shader geometry
 #version 410 core
+
+// Variant without the explosion, see ShaderDefines
+#ifndef EXPLODE
+#define EXPLODE 1
+#endif
 layout( triangles ) in;
 layout( triangle_strip, max_vertices = 3 ) out;
 
@@ -38,8 +80,10 @@ in VS_OUT{
     vec2 ourTexture;
     float v_TexIndex;
     vec3 v_Color;
-    vec3 v_Normal;
     vec3 v_FragPos;
+#ifdef HAS_NORMAL
+    vec3 v_Normal;
+#endif
 } gs_in[];
 
 out vec2 OurTexture;
@@ -48,6 +92,7 @@ out vec3 g_Normal;
 out vec3 g_FragPos;
 out float g_TexIndex;
 
+#if EXPLODE
 uniform float time;
 uniform float magnitude;
 vec4 explode( vec4 position, vec3 normal ){
@@ -62,36 +107,56 @@ vec3 GetNormal(){
     vec3 c = a + b;
     return normalize( c );
 }
+#else
+// The triangles stay where the vertex shader put them, only the face normal is left to compute
+vec4 explode( vec4 position, vec3 normal ){
+    return position;
+}
+#endif
+
+#ifndef HAS_NORMAL
+// Every normal of the tilling is the one of its face ( TriangleT::GetNormalOfTriangle ), in world space here.
+// Only for the formats without normals, the others pass on the one of each vertex
+vec3 GetFaceNormal(){
+    vec3 u = gs_in[ 1 ].v_FragPos - gs_in[ 0 ].v_FragPos;
+    vec3 v = gs_in[ 2 ].v_FragPos - gs_in[ 0 ].v_FragPos;
+    return normalize( cross( u, v ) );
+}
+#endif
 
 void main(){
-    vec3 normal;
-
-    if( time == 0 ){
-        normal = vec3( 0.0, 0.0, 0.0 );
-    } else{
-
+    vec3 normal = vec3( 0.0, 0.0, 0.0 );
+#ifdef HAS_NORMAL
+    vec3 normals[ 3 ] = vec3[ 3 ]( gs_in[ 0 ].v_Normal, gs_in[ 1 ].v_Normal, gs_in[ 2 ].v_Normal );
+#else
+    vec3 faceNormal = GetFaceNormal();
+    vec3 normals[ 3 ] = vec3[ 3 ]( faceNormal, faceNormal, faceNormal );
+#endif
+
+#if EXPLODE
+    if( time != 0 )
         normal = GetNormal();
-    }
+#endif
 
     gl_Position = explode( gl_in[ 0 ].gl_Position, normal );
     OurTexture = gs_in[ 0 ].ourTexture;
     g_TexIndex = gs_in[ 0 ].v_TexIndex;
     g_Color = gs_in[ 0 ].v_Color;
-    g_Normal = gs_in[ 0 ].v_Normal;
+    g_Normal = normals[ 0 ];
     g_FragPos = gs_in[ 0 ].v_FragPos;
     EmitVertex();
     gl_Position = explode( gl_in[ 1 ].gl_Position, normal );
     OurTexture = gs_in[ 1 ].ourTexture;
     g_TexIndex = gs_in[ 1 ].v_TexIndex;
     g_Color = gs_in[ 1 ].v_Color;
-    g_Normal = gs_in[ 1 ].v_Normal;
+    g_Normal = normals[ 1 ];
     g_FragPos = gs_in[ 1 ].v_FragPos;
     EmitVertex();
     gl_Position = explode( gl_in[ 2 ].gl_Position, normal );
     OurTexture = gs_in[ 2 ].ourTexture;
     g_TexIndex = gs_in[ 2 ].v_TexIndex;
     g_Color = gs_in[ 2 ].v_Color;
-    g_Normal = gs_in[ 2 ].v_Normal;
+    g_Normal = normals[ 2 ];
     g_FragPos = gs_in[ 2 ].v_FragPos;
     EmitVertex();
     EndPrimitive();
@@ -102,17 +167,36 @@ void main(){
 #shader fragment
 #version 410 core
 
+// Size of the point light array of LightsBlock, always given by the application from NR_POINT_LIGHTS of Lights.h
+#ifndef MAX_POINT_LIGHTS
+#error MAX_POINT_LIGHTS must be defined as NR_POINT_LIGHTS of Lights.h
+#endif
+
+// Features of the variant, see ShaderDefines. Without defines every one is on
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS MAX_POINT_LIGHTS
+#endif
+#ifndef DIR_LIGHT
+#define DIR_LIGHT 1
+#endif
+#ifndef SPOT_LIGHT
+#define SPOT_LIGHT 1
+#endif
+#ifndef TEXTURED
+#define TEXTURED 1
+#endif
+
 out vec4 FragColor;
 
+// Members ordered so std140 packs each float after a vec3, as the structs of UniformBlocks.h
+
 struct Material{
-    sampler2D diffuse[ 3 ];
     vec3 specular;
     float shininess;
 };
 
 struct DirLight{
     vec3 direction;
-
     vec3 ambient;
     vec3 diffuse;
     vec3 specular;
@@ -120,33 +204,27 @@ struct DirLight{
 
 struct PointLight{
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
-
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
 struct SpotLight{
     vec3 position;
-    vec3 direction;
     float cutOff;
+    vec3 direction;
     float outerCutOff;
-
-    float constant;
-    float linear;
-    float quadratic;
-
     vec3 ambient;
+    float constant;
     vec3 diffuse;
+    float linear;
     vec3 specular;
+    float quadratic;
 };
 
-#define NR_POINT_LIGHTS 4
-
 in vec2 OurTexture;
 
 in float g_TexIndex;
@@ -157,11 +235,31 @@ in vec3 g_FragPos;
 int index = int( g_TexIndex );
 
 //uniform sampler2D u_Textures[3];
-uniform vec3 viewPos;
-uniform Material material;
-uniform DirLight dirLight;
-uniform PointLight pointLights[ NR_POINT_LIGHTS ];
-uniform SpotLight spotLight;
+#if TEXTURED
+// Samplers can't be in a block, the diffuse textures of the material stay apart
+uniform sampler2D diffuseMaps[ 3 ];
+#endif
+
+// Diffuse color of the fragment, from the texture of its tile or its flat color
+vec3 albedo;
+
+layout( std140 ) uniform CameraBlock{
+    mat4 projection;
+    mat4 view;
+    mat4 model;
+    vec3 viewPos;
+};
+
+layout( std140 ) uniform LightsBlock{
+    DirLight dirLight;
+    // The layout stays the same in every variant, the ones with fewer lights ignore the rest
+    PointLight pointLights[ MAX_POINT_LIGHTS ];
+    SpotLight spotLight;
+};
+
+layout( std140 ) uniform MaterialBlock{
+    Material material;
+};
 
 // function prototypes
 vec3 CalcDirLight( DirLight light, vec3 normal, vec3 viewDir );
@@ -173,6 +271,11 @@ void main(){
     // properties
     vec3 norm = normalize( g_Normal );
     vec3 viewDir = normalize( viewPos - g_FragPos );
+#if TEXTURED
+    albedo = vec3( texture( diffuseMaps[ index ], OurTexture ) );
+#else
+    albedo = g_Color;
+#endif
 
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
@@ -180,13 +283,19 @@ void main(){
     // per lamp. In the main() function we take all the calculated colors and sum them up for
     // this fragment's final color.
     // == =====================================================
+    // Each phase is only compiled into the variants that have it
+    vec3 result = vec3( 0.0 );
     // phase 1: directional lighting
-    vec3 result = CalcDirLight( dirLight, norm, viewDir );
+#if DIR_LIGHT
+    result += CalcDirLight( dirLight, norm, viewDir );
+#endif
     // phase 2: point lights
     for( int i = 0; i < NR_POINT_LIGHTS; i++ )
         result += CalcPointLight( pointLights[ i ], norm, g_FragPos, viewDir );
     // phase 3: spot light
+#if SPOT_LIGHT
     result += CalcSpotLight( spotLight, norm, g_FragPos, viewDir );
+#endif
 
     FragColor = vec4( result, 1.0 );
 
@@ -204,8 +313,8 @@ vec3 CalcDirLight( DirLight light, vec3 normal, vec3 viewDir ){
     vec3 reflectDir = reflect( -lightDir, normal );
     float spec = pow( max( dot( viewDir, reflectDir ), 0.0 ), material.shininess );
     // combine results
-    vec3 ambient = light.ambient * vec3( texture( material.diffuse[ index ], OurTexture ) );
-    vec3 diffuse = light.diffuse * diff * vec3( texture( material.diffuse[ index ], OurTexture ) );
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
     vec3 specular = light.specular * spec * material.specular;
     return ( ambient + diffuse + specular );
 }
@@ -222,8 +331,8 @@ vec3 CalcPointLight( PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir )
     float distance = length( light.position - fragPos );
     float attenuation = 1.0 / ( light.constant + light.linear * distance + light.quadratic * ( distance * distance ) );
     // combine results
-    vec3 ambient = light.ambient * vec3( texture( material.diffuse[ index ], OurTexture ) );
-    vec3 diffuse = light.diffuse * diff * vec3( texture( material.diffuse[ index ], OurTexture ) );
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
     vec3 specular = light.specular * spec * material.specular;
     ambient *= attenuation;
     diffuse *= attenuation;
@@ -247,8 +356,8 @@ vec3 CalcSpotLight( SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir ){
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp( ( theta - light.outerCutOff ) / epsilon, 0.0, 1.0 );
     // combine results
-    vec3 ambient = light.ambient * vec3( texture( material.diffuse[ index ], OurTexture ) );
-    vec3 diffuse = light.diffuse * diff * vec3( texture( material.diffuse[ index ], OurTexture ) );
+    vec3 ambient = light.ambient * albedo;
+    vec3 diffuse = light.diffuse * diff * albedo;
     vec3 specular = light.specular * spec * material.specular;
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
@@ -12,6 +12,7 @@
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <memory>
 #include <vector>
 
 #include "Renderer.h"
@@ -21,10 +22,18 @@
 #include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "Shader.h"
+#include "ShaderVariants.h"
 #include "Texture.h"
 #include "Camera.h"
+#include "UniformBuffer.h"
+#include "UniformBlocks.h"
 
+#include "Arena.h"
 #include "Penrose.h"
+#include "InstancedTilling.h"
+#include "SubstitutionDag.h"
+#include "Profiler.h"
+#include "FrameProfiler.h"
 
 
 void framebuffer_size_callback( GLFWwindow *window, int width, int height );
@@ -39,6 +48,12 @@ unsigned int SCR_HEIGHT = 1080;
 // Tilling Settings
 const float TILLING_DIAMETER = 1.0f;
 const float PARTITIONS = 3;
+// Vertex layout of the scene, the buffer, the GL layout and the shader inputs all follow it.
+// 16 bytes per vertex with everything but the position derived in the shader, TileHalfFormat goes down to 8.
+// PackedFormat ( 24 ) and PositionColorTexCoordNormalFormat ( 48 ) store every attribute
+typedef TileFormat SceneFormat;
+// Height of the pyramids of Penrose::DoIt3D
+const float EXTRUSION_HEIGHT = 1.0f;
 
 // camera
 Camera camera( glm::vec3( 0.0f, 0.0f, 3.0f ) );
@@ -89,42 +104,72 @@ int main( void ){
 
     {
 
-        Penrose p( PARTITIONS, Coordinate( 0.0, 0.0 ), 36, TILLING_DIAMETER );
+        GLCall( glEnable( GL_BLEND ) );
+        GLCall( glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ) );
 
-        p.execute();
-        p.DoIt3D();
+        VertexArray va;
+        std::unique_ptr<VertexBuffer> vb;
+        std::unique_ptr<IndexBuffer> ib;
+
+        VertexBufferLayout layout = VertexBufferLayout::FromFormat<SceneFormat>();
+
+        // Two prototypes and 16 bytes per tile instead of every vertex of the tilling. The prototypes are
+        // supertiles of prototypeDepth levels and only the levels above them become instances
+        InstancedTilling instancedTilling;
+        bool instanced = true;
+        int prototypeDepth = 3;
+        // The instances rewritten every frame through a ring of buffers, swaying the tiles
+        bool swayTiles = false;
+
+        // Every buffer of a generation lives in the arena, generating again resets it and reuses its memory
+        Arena arena;
+        int partitions = ( int ) PARTITIONS;
+        auto generate = [ & ]( int level ){
+            arena.Reset();
+
+            if( instanced ){
+                vb.reset();
+                SubstitutionDag dag( level, CoordinateT<double>( 0.0, 0.0 ), 36, TILLING_DIAMETER );
+                instancedTilling.Upload( dag, std::min( prototypeDepth, level ), EXTRUSION_HEIGHT, arena, swayTiles );
+                std::cout << "tringulos: " << dag.GetNumTiles() * 4 << " from " << dag.GetNumNodes() << " DAG nodes, " <<
+                    instancedTilling.GetNumInstances() << " instances, " << instancedTilling.GetBytes() / 1024 << " KB" << std::endl;
+                return;
+            }
+            instancedTilling.Clear();
 
-        float *vertices = p.GetVerticesWithColorsTexCoordsAndNormalLight();
-        int numVertices = p.GetNumTriangles() * 36;
+            Penrose p( level, Coordinate( 0.0, 0.0 ), 36, TILLING_DIAMETER, &arena );
+            p.execute();
 
-        int numIndices = p.GetNumTriangles() * 3;
+            p.DoIt3D( EXTRUSION_HEIGHT );
 
-        unsigned int *indices = new unsigned int[ numIndices ];
-        for( int i = 0; i < numIndices; i++ ){
-            indices[ i ] = i;
-        }
+            // The vertices are packed straight into the mapped buffer, kept while the tilling fits in it
+            size_t numBytes = p.GetVertexBytes<SceneFormat>();
+            if( !vb || vb->GetSize() < numBytes ){
+                vb.reset();
+                vb.reset( new VertexBuffer( ( unsigned int ) numBytes ) );
+                va.AddBuffer( *vb, layout );
+            }
+            unsigned char *vertices = static_cast< unsigned char * >( vb->Map() );
+            p.PackVertices<SceneFormat>( Span<unsigned char>( vertices, numBytes ) );
+            RenderStats::AddUploadedBytes( numBytes );
 
-        IndexBuffer ib( indices, numIndices );
+            int numIndices = p.GetNumTriangles() * 3;
 
-        std::cout << "tringulos: " << p.GetNumTriangles() << std::endl;
-        GLCall( glEnable( GL_BLEND ) );
-        GLCall( glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ) );
-
-        VertexArray va;
+            unsigned int *indices = arena.AllocateArray<unsigned int>( numIndices );
+            for( int i = 0; i < numIndices; i++ ){
+                indices[ i ] = i;
+            }
 
-        VertexBuffer vb( vertices, numVertices * sizeof( float ) );
+            // Regenerating orphans and refills the same buffer
+            if( ib )
+                ib->SetData( indices, numIndices );
+            else
+                ib.reset( new IndexBuffer( indices, numIndices, GL_DYNAMIC_DRAW ) );
 
-        VertexBufferLayout layout;
-        layout.Push<float>( 3 );
-        layout.Push<float>( 3 );
-        layout.Push<float>( 2 );
-        layout.Push<float>( 1 );
-        layout.Push<float>( 3 );
-        va.AddBuffer( vb, layout );
-        va.Bind();
+            std::cout << "tringulos: " << p.GetNumTriangles() << ", arena " << arena.GetUsed() / 1024 << " KB" << std::endl;
+        };
 
-        Shader shader( "res/shaders/project.shader" );
-        shader.Bind();
+        generate( partitions );
 
         Texture texture_1( "res/textures/nether_brick.png" );
         Texture texture_2( "res/textures/amatista_block.png" );
@@ -133,12 +178,51 @@ int main( void ){
         GLuint m_texture_2 = texture_2.GetM_RendererID();
         GLCall( glBindTextureUnit( 2, m_texture_1 ) );
         GLCall( glBindTextureUnit( 1, m_texture_2 ) );
-        int samplers[ 3 ] = { 0, 1, 2 };
-        shader.Setuniforms1iv( "material.diffuse", 3, samplers );
 
-        va.UnBind();
-        shader.UnBind();
-        vb.UnBind();
+        // A program per combination of the features in use, compiled the first time it's drawn with
+        auto setupShader = []( Shader &shader ){
+            int samplers[ 3 ] = { 0, 1, 2 };
+            shader.Bind();
+            if( shader.IsUniformActive( "diffuseMaps" ) )
+                shader.Setuniforms1iv( "diffuseMaps", 3, samplers );
+            shader.SetUniformBlockBinding( CameraBlock::NAME, CameraBlock::BINDING );
+            shader.SetUniformBlockBinding( LightsBlock::NAME, LightsBlock::BINDING );
+            shader.SetUniformBlockBinding( MaterialBlock::NAME, MaterialBlock::BINDING );
+            shader.UnBind();
+        };
+        ShaderVariants sceneShaders( "res/shaders/project.shader", GlslVertexInputs<SceneFormat>(), setupShader );
+        ShaderVariants instancedShaders( "res/shaders/project.shader", InstancedTilling::GetVertexInputs(), setupShader );
+
+        // What the UI leaves on, the features of project.shader that are off aren't compiled in
+        int pointLights = NR_POINT_LIGHTS;
+        bool dirLight = true;
+        bool spotLight = true;
+        bool textured = true;
+
+        // The uniforms left outside the blocks, resolved again when the variant changes
+        struct ExplodeUniforms{
+            Uniform<float> time;
+            Uniform<float> magnitude;
+        };
+        ExplodeUniforms explodeUniforms;
+
+        // The features the variant in use was picked for, the defines are only built again when one changes
+        struct ShaderFeatures{
+            int pointLights;
+            bool dirLight, spotLight, textured, explode, instanced;
+
+            bool operator==( const ShaderFeatures &other ) const{
+                return pointLights == other.pointLights && dirLight == other.dirLight && spotLight == other.spotLight &&
+                    textured == other.textured && explode == other.explode && instanced == other.instanced;
+            }
+        };
+        ShaderFeatures shaderFeatures = { -1 };
+        Shader *shader = nullptr;
+
+        // Filled once per frame and only sent to GL when they change
+        UniformBlock<CameraBlock> cameraBlock;
+        UniformBlock<LightsBlock> lightsBlock;
+        UniformBlock<MaterialBlock> materialBlock;
 
         Renderer renderer;
 
@@ -151,6 +235,9 @@ int main( void ){
         // Setup style
         ImGui::StyleColorsDark();
 
+        // Per-frame CPU and GPU timings for the "Profiler" window
+        FrameProfiler frameProfiler;
+
         // Variables
         // for projection
         float near = 3.0;
@@ -162,23 +249,46 @@ int main( void ){
         glm::vec3 rotate_Vector( 1.0f, 0.0f, 0.0f );
         glm::vec3 scale_Vector( 1.0, 1.0, 0.5 );
 
-        // For light
-        glm::vec3 lightPosition( 0.0, 0.0, 5.0 );
-        // positions of the point lights
-        glm::vec3 pointLightPositions[] = {
-            glm::vec3( 2.7f,  2.2f,  2.0f ),
-            glm::vec3( 2.3f, -3.3f, -4.0f ),
-            glm::vec3( -4.0f,  2.0f, -10.0f ),
-            glm::vec3( 3.0f,  3.0f, -3.0f )
-        };
+        // For light, the spot light follows the camera
+        SceneLights lights = SceneLights::Default( camera.Position, camera.Front );
 
         // For animation
         float explotion_scale = 1.0;
         float magnitude = 6.0;
         float time;
         bool stop_animation = false;
+
+        // Set by the UI, the tilling is rebuilt at the start of the next frame
+        bool regenerate = false;
         /* Loop until the user closes the window */
         while( !glfwWindowShouldClose( window ) ){
+            PROFILE_SCOPE( "Frame" );
+            frameProfiler.NewFrame();
+
+            if( regenerate ){
+                generate( partitions );
+                regenerate = false;
+            }
+            // project.shader saved since the last frame is compiled in the background, the old programs draw meanwhile
+            sceneShaders.Poll();
+            instancedShaders.Poll();
+
+            // Stopped once the first explosion is over, the triangles stay in place
+            const bool explode = magnitude > 0 || !stop_animation;
+            const ShaderFeatures features = { pointLights, dirLight, spotLight, textured, explode, instanced };
+            if( !( features == shaderFeatures ) ){
+                ShaderDefines defines;
+                defines.Set( "MAX_POINT_LIGHTS", NR_POINT_LIGHTS ).Set( "NR_POINT_LIGHTS", pointLights );
+                defines.Set( "DIR_LIGHT", dirLight ).Set( "SPOT_LIGHT", spotLight );
+                defines.Set( "TEXTURED", textured ).Set( "EXPLODE", explode );
+                shader = &( instanced ? instancedShaders : sceneShaders ).Get( defines );
+
+                explodeUniforms = ExplodeUniforms();
+                if( explode )
+                    explodeUniforms = { shader->GetUniform<float>( "time" ), shader->GetUniform<float>( "magnitude" ) };
+                shaderFeatures = features;
+            }
+
             // per - frame time logic
             // --------------------
             float currentFrame = glfwGetTime();
@@ -188,14 +298,15 @@ int main( void ){
             /* Render here */
             renderer.Clear();
 
+            frameProfiler.Begin( CpuSection::ImGui );
             ImGui_ImplGlfwGL3_NewFrame();
+            frameProfiler.End( CpuSection::ImGui );
 
+            frameProfiler.Begin( CpuSection::Input );
             processInput( window );
+            frameProfiler.End( CpuSection::Input );
 
-            shader.Bind();
-
-            vb.Bind();
-            va.Bind();
+            shader->Bind();
 
             {
 
@@ -212,93 +323,57 @@ int main( void ){
                 model = glm::rotate( model, rotate_angle, rotate_Vector );
                 model = glm::scale( model, scale_Vector );
 
-                // Set uniforms
-                shader.SetuniformsMat4f( "projection", projection );
-                shader.SetuniformsMat4f( "view", view );
-                shader.SetuniformsMat4f( "model", model );
-                shader.SetuniformsVec3( "viewPos", camera.Position );
-
-                if( stop_animation ){
-                    time = 0;
-                } else{
-                    time = glfwGetTime();
-                }
+                {
+                    PROFILE_SCOPE( "Uniforms" );
+                    FrameProfiler::CpuScope uniformsScope( frameProfiler, CpuSection::Uniforms );
+
+                    // Set uniforms
+                    lights.viewPos = camera.Position;
+                    lights.spotLight.position = camera.Position;
+                    lights.spotLight.direction = camera.Front;
+                    cameraBlock.Set( CameraBlock::From( projection, view, model, lights.viewPos ) );
+                    lightsBlock.Set( LightsBlock::From( lights ) );
+                    materialBlock.Set( MaterialBlock::From( lights.material ) );
+                    cameraBlock.Upload();
+                    lightsBlock.Upload();
+                    materialBlock.Upload();
+
+                    if( stop_animation ){
+                        time = 0;
+                    } else{
+                        time = glfwGetTime();
+                    }
 
-                if( magnitude > 0 ){
-                    shader.SetUniformFloat( "time", 3.14159265359 );
-                    shader.SetUniformFloat( "magnitude", magnitude );
-                    magnitude -= 0.015;
-                } else{
-                    shader.SetUniformFloat( "magnitude", 1 * explotion_scale );
-                    shader.SetUniformFloat( "time", time );
+                    if( magnitude > 0 ){
+                        explodeUniforms.time.Set( 3.14159265359f );
+                        explodeUniforms.magnitude.Set( magnitude );
+                        magnitude -= 0.015;
+                    } else if( explode ){
+                        explodeUniforms.magnitude.Set( 1 * explotion_scale );
+                        explodeUniforms.time.Set( time );
+                    }
                 }
 
-                /*
-                 * Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index
-                 * the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-                 * by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-                 * by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-                 */
-
-                 // directional light
-                shader.SetuniformsVec3( "dirLight.direction", lightPosition );
-                shader.SetuniformsVec3( "dirLight.ambient", glm::vec3( 0.05f, 0.05f, 0.05f ) );
-                shader.SetuniformsVec3( "dirLight.diffuse", glm::vec3( 0.9f, 0.9f, 0.9f ) );
-                shader.SetuniformsVec3( "dirLight.specular", glm::vec3( 0.5f, 0.5f, 0.5f ) );
-                // point light 1
-                shader.SetuniformsVec3( "pointLights[0].position", pointLightPositions[ 0 ] );
-                shader.SetuniformsVec3( "pointLights[0].ambient", glm::vec3( 0.05f, 0.05f, 0.05f ) );
-                shader.SetuniformsVec3( "pointLights[0].diffuse", glm::vec3( 0.8f, 0.8f, 0.8f ) );
-                shader.SetuniformsVec3( "pointLights[0].specular", glm::vec3( 1.0f, 1.0f, 1.0f ) );
-                shader.SetUniformFloat( "pointLights[0].constant", 1.0f );
-                shader.SetUniformFloat( "pointLights[0].linear", 0.09 );
-                shader.SetUniformFloat( "pointLights[0].quadratic", 0.032 );
-                // point light 2
-                shader.SetuniformsVec3( "pointLights[1].position", pointLightPositions[ 1 ] );
-                shader.SetuniformsVec3( "pointLights[1].ambient", glm::vec3( 0.05f, 0.05f, 0.05f ) );
-                shader.SetuniformsVec3( "pointLights[1].diffuse", glm::vec3( 0.8f, 0.8f, 0.8f ) );
-                shader.SetuniformsVec3( "pointLights[1].specular", glm::vec3( 1.0f, 1.0f, 1.0f ) );
-                shader.SetUniformFloat( "pointLights[1].constant", 1.0f );
-                shader.SetUniformFloat( "pointLights[1].linear", 0.09 );
-                shader.SetUniformFloat( "pointLights[1].quadratic", 0.032 );
-                // point light 3
-                shader.SetuniformsVec3( "pointLights[2].position", pointLightPositions[ 2 ] );
-                shader.SetuniformsVec3( "pointLights[2].ambient", glm::vec3( 0.05f, 0.05f, 0.05f ) );
-                shader.SetuniformsVec3( "pointLights[2].diffuse", glm::vec3( 0.8f, 0.8f, 0.8f ) );
-                shader.SetuniformsVec3( "pointLights[2].specular", glm::vec3( 1.0f, 1.0f, 1.0f ) );
-                shader.SetUniformFloat( "pointLights[2].constant", 1.0f );
-                shader.SetUniformFloat( "pointLights[2].linear", 0.09 );
-                shader.SetUniformFloat( "pointLights[2].quadratic", 0.032 );
-                // point light 4
-                shader.SetuniformsVec3( "pointLights[3].position", pointLightPositions[ 3 ] );
-                shader.SetuniformsVec3( "pointLights[3].ambient", glm::vec3( 0.05f, 0.05f, 0.05f ) );
-                shader.SetuniformsVec3( "pointLights[3].diffuse", glm::vec3( 0.8f, 0.8f, 0.8f ) );
-                shader.SetuniformsVec3( "pointLights[3].specular", glm::vec3( 1.0f, 1.0f, 1.0f ) );
-                shader.SetUniformFloat( "pointLights[3].constant", 1.0f );
-                shader.SetUniformFloat( "pointLights[3].linear", 0.09 );
-                shader.SetUniformFloat( "pointLights[3].quadratic", 0.032 );
-                // spotLight
-                shader.SetuniformsVec3( "spotLight.position", camera.Position );
-                shader.SetuniformsVec3( "spotLight.direction", camera.Front );
-                shader.SetuniformsVec3( "spotLight.ambient", glm::vec3( 0.0f, 0.0f, 0.0f ) );
-                shader.SetuniformsVec3( "spotLight.diffuse", glm::vec3( 1.0f, 1.0f, 1.0f ) );
-                shader.SetuniformsVec3( "spotLight.specular", glm::vec3( 1.0f, 1.0f, 1.0f ) );
-                shader.SetUniformFloat( "spotLight.constant", 1.0f );
-                shader.SetUniformFloat( "spotLight.linear", 0.09 );
-                shader.SetUniformFloat( "spotLight.quadratic", 0.032 );
-                shader.SetUniformFloat( "spotLight.cutOff", glm::cos( glm::radians( 12.5f ) ) );
-                shader.SetUniformFloat( "spotLight.outerCutOff", glm::cos( glm::radians( 15.0f ) ) );
-
-                // material properties
-                shader.SetuniformsVec3( "material.specular", glm::vec3( 0.2f, 0.2f, 0.2f ) );
-                shader.SetUniformFloat( "material.shininess", 45.0f );
                 // Renderer
-                renderer.Draw( va, ib, shader );
+                {
+                    FrameProfiler::CpuScope drawScope( frameProfiler, CpuSection::Draw );
+                    FrameProfiler::GpuScope sceneScope( frameProfiler, GpuPass::Scene );
+                    if( instanced ){
+                        if( instancedTilling.IsStreamed() )
+                            instancedTilling.Stream( currentFrame );
+                        instancedTilling.Draw( renderer, *shader );
+                    }
+                    else{
+                        renderer.Draw( va, *ib, *shader );
+                        vb->Fence();
+                    }
+                }
 
             }
 
             // 1. Show a simple window.
             // Tip: if we don't call ImGui::Begin()/ImGui::End() the widgets automatically appears in a window called "Debug".
+            frameProfiler.Begin( CpuSection::ImGui );
             ImGui::Begin( "Controls" );
             {
 
@@ -315,33 +390,41 @@ int main( void ){
 
                 if( ImGui::CollapsingHeader( "Lights" ) ){
 
+                    // Each combination is a shader variant, the lights turned off cost nothing
+                    ImGui::SliderInt( "Point lights", &pointLights, 0, NR_POINT_LIGHTS );
+                    ImGui::Checkbox( "Directional light", &dirLight );
+                    ImGui::SameLine();
+                    ImGui::Checkbox( "Spot light", &spotLight );
+                    ImGui::Checkbox( "Textured", &textured );
+                    ImGui::Text( "Shader variants: %d", ( int ) ( sceneShaders.GetNumVariants() + instancedShaders.GetNumVariants() ) );
+
                     if( ImGui::TreeNode( "Directional Light" ) ){
                         // mover posicin
-                        ImGui::SliderFloat3( "Move directional light", &lightPosition.x, -10.0f, 10.0f );
+                        ImGui::SliderFloat3( "Move directional light", &lights.dirLight.direction.x, -10.0f, 10.0f );
                         ImGui::TreePop();
                     }
 
                     if( ImGui::TreeNode( "Light point 1" ) ){
                         // mover posicin
-                        ImGui::SliderFloat3( "Move light point 1", &pointLightPositions[ 0 ].x, -10.0f, 10.0f );
+                        ImGui::SliderFloat3( "Move light point 1", &lights.pointLights[ 0 ].position.x, -10.0f, 10.0f );
                         ImGui::TreePop();
                     }
 
                     if( ImGui::TreeNode( "Light point 2" ) ){
                         // mover posicin
-                        ImGui::SliderFloat3( "Move light point 1", &pointLightPositions[ 1 ].x, -10.0f, 10.0f );
+                        ImGui::SliderFloat3( "Move light point 1", &lights.pointLights[ 1 ].position.x, -10.0f, 10.0f );
                         ImGui::TreePop();
                     }
 
                     if( ImGui::TreeNode( "Light point 3" ) ){
                         // mover posicin
-                        ImGui::SliderFloat3( "Move light point 3", &pointLightPositions[ 2 ].x, -10.0f, 10.0f );
+                        ImGui::SliderFloat3( "Move light point 3", &lights.pointLights[ 2 ].position.x, -10.0f, 10.0f );
                         ImGui::TreePop();
                     }
 
                     if( ImGui::TreeNode( "Light point 4" ) ){
                         // mover posicin
-                        ImGui::SliderFloat3( "Move light point 4", &pointLightPositions[ 3 ].x, -10.0f, 10.0f );
+                        ImGui::SliderFloat3( "Move light point 4", &lights.pointLights[ 3 ].position.x, -10.0f, 10.0f );
                         ImGui::TreePop();
                     }
 
@@ -365,8 +448,25 @@ int main( void ){
                     ImGui::SliderFloat( "angle or zoom", &camera.Zoom, 0.0, 50.0 );
                 }
 
+                if( ImGui::CollapsingHeader( "Tilling" ) ){
+                    // Instanced the memory is the supertiles and their instances, not the whole tilling
+                    ImGui::SliderInt( "Partitions", &partitions, 0, instanced ? 12 : 9 );
+                    if( ImGui::Checkbox( "Instanced", &instanced ) ){
+                        partitions = std::min( partitions, 9 );
+                        regenerate = true;
+                    }
+                    if( instanced )
+                        ImGui::SliderInt( "Prototype levels", &prototypeDepth, 0, partitions );
+                    if( ImGui::Button( "Generate" ) )
+                        regenerate = true;
+                    ImGui::Text( "Arena: %.1f KB used, %.1f KB high-water, %.1f KB in %d blocks", arena.GetUsed() / 1024.0f,
+                        arena.GetHighWaterMark() / 1024.0f, arena.GetCapacity() / 1024.0f, ( int ) arena.GetBlockCount() );
+                }
+
                 if( ImGui::CollapsingHeader( "Animation" ) ){
                     ImGui::Checkbox( "Stop Animation", &stop_animation );
+                    if( instanced && ImGui::Checkbox( "Sway tiles", &swayTiles ) )
+                        regenerate = true;
                     ImGui::TextWrapped( "Increase size of explotion." );
                     ImGui::InputFloat( "Scale:", &explotion_scale );
                 }
@@ -376,18 +476,40 @@ int main( void ){
             }
             ImGui::End();
 
+            frameProfiler.DrawPanel();
+
             ImGui::Render();
-            ImGui_ImplGlfwGL3_RenderDrawData( ImGui::GetDrawData() );
+            {
+                // The ImGui backend streams its whole vertex and index buffers every frame
+                ImDrawData *drawData = ImGui::GetDrawData();
+                RenderStats::AddUploadedBytes( drawData->TotalVtxCount * sizeof( ImDrawVert ) + drawData->TotalIdxCount * sizeof( ImDrawIdx ) );
+
+                FrameProfiler::GpuScope imguiScope( frameProfiler, GpuPass::ImGui );
+                ImGui_ImplGlfwGL3_RenderDrawData( drawData );
+            }
+            frameProfiler.End( CpuSection::ImGui );
 
             /* Swap front and back buffers */
-            GLCall( glfwSwapBuffers( window ) );
+            {
+                FrameProfiler::CpuScope swapScope( frameProfiler, CpuSection::Swap );
+                GLCall( glfwSwapBuffers( window ) );
+            }
 
             /* Poll for and process events */
-            GLCall( glfwPollEvents() );
+            {
+                FrameProfiler::CpuScope inputScope( frameProfiler, CpuSection::Input );
+                GLCall( glfwPollEvents() );
+            }
 
         }
     }
 
+#ifdef PENROSE_PROFILE
+    // Open with chrome://tracing or ui.perfetto.dev
+    if( Profiler::WriteChromeTrace( "penrose_trace.json" ) )
+        std::cout << "Trace written to penrose_trace.json" << std::endl;
+#endif
+
     // Cleanup
     ImGui_ImplGlfwGL3_Shutdown();
     ImGui::DestroyContext();
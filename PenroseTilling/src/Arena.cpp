@@ -0,0 +1,66 @@
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace{
+
+// @return how much has to be skipped from address to reach the alignment
+size_t Padding( const char *address, size_t alignment ){
+	size_t misalignment = reinterpret_cast< uintptr_t >( address ) & ( alignment - 1 );
+	return misalignment ? alignment - misalignment : 0;
+}
+
+}
+
+Arena::Arena( size_t blockSize )
+	: m_Current( 0 ), m_Offset( 0 ), m_Used( 0 ), m_HighWaterMark( 0 ), m_BlockSize( std::max<size_t>( blockSize, 64 ) ){ }
+
+Arena::~Arena(){
+	for( const Block &block : m_Blocks )
+		::operator delete( block.data );
+}
+
+void *Arena::Allocate( size_t bytes, size_t alignment ){
+	// Try the current block, then the ones kept from earlier runs
+	for( ; m_Current < m_Blocks.size(); m_Current++, m_Offset = 0 ){
+		Block &block = m_Blocks[ m_Current ];
+		size_t padding = Padding( block.data + m_Offset, alignment );
+		if( m_Offset + padding + bytes <= block.size ){
+			char *pointer = block.data + m_Offset + padding;
+			m_Offset += padding + bytes;
+			m_Used += padding + bytes;
+			m_HighWaterMark = std::max( m_HighWaterMark, m_Used );
+			return pointer;
+		}
+	}
+
+	// Blocks double with the arena so a growing run needs few of them
+	size_t size = std::max( std::max( m_BlockSize, GetCapacity() ), bytes + alignment );
+	m_Blocks.push_back( { static_cast< char * >( ::operator new( size ) ), size } );
+	m_Current = m_Blocks.size() - 1;
+	m_Offset = 0;
+	return Allocate( bytes, alignment );
+}
+
+void Arena::Reset(){
+	if( m_Blocks.size() > 1 ){
+		size_t capacity = GetCapacity();
+		for( const Block &block : m_Blocks )
+			::operator delete( block.data );
+		m_Blocks.clear();
+		m_Blocks.push_back( { static_cast< char * >( ::operator new( capacity ) ), capacity } );
+	}
+
+	m_Current = 0;
+	m_Offset = 0;
+	m_Used = 0;
+}
+
+size_t Arena::GetCapacity() const{
+	size_t capacity = 0;
+	for( const Block &block : m_Blocks )
+		capacity += block.size;
+	return capacity;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Bump allocator that owns every buffer of a generation run. Allocating only moves an offset,
+ * freeing a single buffer does nothing and Reset releases all of them at once. The blocks are
+ * kept between runs, so generating again reuses the same memory instead of going back to the heap.
+ */
+class Arena{
+private:
+	struct Block{
+		char *data;
+		size_t size;
+	};
+
+	std::vector<Block> m_Blocks;
+	// Block being filled and how much of it is taken
+	size_t m_Current;
+	size_t m_Offset;
+	size_t m_Used;
+	size_t m_HighWaterMark;
+	size_t m_BlockSize;
+
+public:
+	// @param blockSize: Size of the first block, the next ones grow with the arena
+	explicit Arena( size_t blockSize = 1 << 20 );
+	~Arena();
+
+	Arena( const Arena & ) = delete;
+	Arena &operator=( const Arena & ) = delete;
+
+	// @return memory valid until the next Reset, never null
+	void *Allocate( size_t bytes, size_t alignment = alignof( std::max_align_t ) );
+
+	template<typename T>
+	T *AllocateArray( size_t count ){
+		static_assert( std::is_trivially_destructible<T>::value, "The arena never runs destructors" );
+		return static_cast< T * >( Allocate( count * sizeof( T ), alignof( T ) ) );
+	}
+
+	/**
+	 * Forget every allocation. When the last run needed more than one block they are merged
+	 * into a single one of the same total size, so a run of the same size fits without growing.
+	 */
+	void Reset();
+
+	// @return bytes handed out since the last Reset, padding included
+	inline size_t GetUsed() const{ return m_Used; }
+	// @return the most GetUsed has been since the arena was created
+	inline size_t GetHighWaterMark() const{ return m_HighWaterMark; }
+	// @return bytes held from the heap
+	size_t GetCapacity() const;
+	inline size_t GetBlockCount() const{ return m_Blocks.size(); }
+};
+
+/**
+ * Standard allocator over an Arena so containers can live in it. Without an arena it falls
+ * back to the heap, which keeps the containers usable by code that doesn't care about arenas.
+ */
+template<typename T>
+class ArenaAllocator{
+private:
+	Arena *m_Arena;
+
+public:
+	typedef T value_type;
+	typedef std::true_type propagate_on_container_copy_assignment;
+	typedef std::true_type propagate_on_container_move_assignment;
+	typedef std::true_type propagate_on_container_swap;
+
+	ArenaAllocator( Arena *arena = nullptr ) noexcept
+		: m_Arena( arena ){ }
+
+	template<typename U>
+	ArenaAllocator( const ArenaAllocator<U> &other ) noexcept
+		: m_Arena( other.GetArena() ){ }
+
+	T *allocate( size_t count ){
+		if( m_Arena )
+			return static_cast< T * >( m_Arena->Allocate( count * sizeof( T ), alignof( T ) ) );
+		return static_cast< T * >( ::operator new( count * sizeof( T ) ) );
+	}
+
+	void deallocate( T *pointer, size_t ){
+		if( !m_Arena )
+			::operator delete( pointer );
+	}
+
+	inline Arena *GetArena() const{ return m_Arena; }
+};
+
+template<typename T, typename U>
+bool operator==( const ArenaAllocator<T> &a, const ArenaAllocator<U> &b ){
+	return a.GetArena() == b.GetArena();
+}
+
+template<typename T, typename U>
+bool operator!=( const ArenaAllocator<T> &a, const ArenaAllocator<U> &b ){
+	return !( a == b );
+}
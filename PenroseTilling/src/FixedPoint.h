@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Signed 32 bit fixed point scalar with FRACTION_BITS bits after the point.
+ * Same size as a float but with a uniform step of 2^-28 ( ~3.7e-9 ) over the range [-8, 8)
+ */
+struct Fixed32{
+	static const int FRACTION_BITS = 28;
+	// Values are in [-RANGE, RANGE), nothing checks the arithmetic so the callers must stay inside
+	static constexpr double RANGE = ( double ) ( 1 << ( 31 - FRACTION_BITS ) );
+
+	int32_t raw;
+
+	Fixed32(){
+		raw = 0;
+	}
+
+	Fixed32( double value ){
+		assert( value >= -RANGE && value < RANGE && "Fixed32 out of range, it would wrap" );
+		raw = ( int32_t ) llround( value * ( double ) ( 1 << FRACTION_BITS ) );
+	}
+
+	// @return a fixed point value from its raw representation
+	static Fixed32 FromRaw( int32_t value ){
+		Fixed32 result;
+		result.raw = value;
+		return result;
+	}
+
+	explicit operator double() const{ return ( double ) raw / ( double ) ( 1 << FRACTION_BITS ); }
+	explicit operator float() const{ return ( float ) ( double ) *this; }
+
+	Fixed32 operator-() const{ return FromRaw( -raw ); }
+	Fixed32 operator+( Fixed32 b ) const{ return FromRaw( raw + b.raw ); }
+	Fixed32 operator-( Fixed32 b ) const{ return FromRaw( raw - b.raw ); }
+	Fixed32 operator*( Fixed32 b ) const{ return FromRaw( ( int32_t ) ( ( ( int64_t ) raw * b.raw ) >> FRACTION_BITS ) ); }
+	Fixed32 operator/( Fixed32 b ) const{ return FromRaw( ( int32_t ) ( ( ( int64_t ) raw << FRACTION_BITS ) / b.raw ) ); }
+
+	Fixed32 &operator+=( Fixed32 b ){ raw += b.raw; return *this; }
+	Fixed32 &operator-=( Fixed32 b ){ raw -= b.raw; return *this; }
+
+	bool operator==( Fixed32 b ) const{ return raw == b.raw; }
+	bool operator!=( Fixed32 b ) const{ return raw != b.raw; }
+	bool operator<( Fixed32 b ) const{ return raw < b.raw; }
+};
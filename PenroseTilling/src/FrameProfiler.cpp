@@ -0,0 +1,197 @@
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "imgui/imgui.h"
+
+#include "Renderer.h"
+
+namespace{
+
+const char *CPU_SECTION_NAMES[] = { "Input", "Uniforms", "Draw", "ImGui", "Swap" };
+const char *GPU_PASS_NAMES[] = { "Scene", "ImGui" };
+
+float HistoryGetter( void *data, int index ){
+	return static_cast< RollingHistory * >( data )->Get( index );
+}
+
+// One histogram with its percentiles under it
+void DrawHistory( const char *label, const RollingHistory &history, const char *unit ){
+	ImGui::PlotHistogram( label, HistoryGetter, const_cast< RollingHistory * >( &history ), ( int ) history.GetSize(),
+		0, nullptr, 0.0f, FLT_MAX, ImVec2( 0.0f, 40.0f ) );
+	ImGui::Text( "    last %.3f  p50 %.3f  p95 %.3f  p99 %.3f %s", history.Last(),
+		history.Percentile( 50.0f ), history.Percentile( 95.0f ), history.Percentile( 99.0f ), unit );
+}
+
+}
+
+RollingHistory::RollingHistory( size_t capacity )
+	: m_Values( capacity, 0.0f ), m_Next( 0 ), m_Size( 0 ){ }
+
+void RollingHistory::Push( float value ){
+	m_Values[ m_Next ] = value;
+	m_Next = ( m_Next + 1 ) % m_Values.size();
+	m_Size = std::min( m_Size + 1, m_Values.size() );
+}
+
+float RollingHistory::Get( size_t index ) const{
+	size_t oldest = ( m_Next + m_Values.size() - m_Size ) % m_Values.size();
+	return m_Values[ ( oldest + index ) % m_Values.size() ];
+}
+
+float RollingHistory::Percentile( float percentile ) const{
+	if( m_Size == 0 )
+		return 0.0f;
+
+	std::vector<float> sorted( m_Size );
+	for( size_t i = 0; i < m_Size; i++ )
+		sorted[ i ] = Get( i );
+
+	size_t rank = std::min( m_Size - 1, ( size_t ) ( percentile / 100.0f * m_Size ) );
+	std::nth_element( sorted.begin(), sorted.begin() + rank, sorted.end() );
+	return sorted[ rank ];
+}
+
+float RollingHistory::Last() const{
+	return m_Size ? Get( m_Size - 1 ) : 0.0f;
+}
+
+FrameProfiler::CpuScope::CpuScope( FrameProfiler &profiler, CpuSection section )
+	: m_Profiler( profiler ), m_Section( section ){
+	m_Profiler.Begin( section );
+}
+
+FrameProfiler::CpuScope::~CpuScope(){
+	m_Profiler.End( m_Section );
+}
+
+FrameProfiler::GpuScope::GpuScope( FrameProfiler &profiler, GpuPass pass )
+	: m_Profiler( profiler ), m_Pass( pass ){
+	int slot = m_Profiler.m_QueryFrame % QUERY_LATENCY;
+	GLCall( glBeginQuery( GL_TIME_ELAPSED, m_Profiler.m_Queries[ ( int ) pass ][ slot ] ) );
+	m_Profiler.m_QueryIssued[ ( int ) pass ][ slot ] = true;
+}
+
+FrameProfiler::GpuScope::~GpuScope(){
+	GLCall( glEndQuery( GL_TIME_ELAPSED ) );
+}
+
+FrameProfiler::FrameProfiler()
+	: m_Cpu( ( int ) CpuSection::Count, RollingHistory( HISTORY ) ), m_Gpu( ( int ) GpuPass::Count, RollingHistory( HISTORY ) ),
+	m_FrameTime( HISTORY ), m_Triangles( HISTORY ), m_UploadedBytes( HISTORY ),
+	m_FrameStarted( false ), m_QueryFrame( 0 ), m_BudgetMs( 1000.0f / 60.0f ){
+	std::fill( m_CpuFrame, m_CpuFrame + ( int ) CpuSection::Count, 0.0f );
+
+	for( int pass = 0; pass < ( int ) GpuPass::Count; pass++ ){
+		GLCall( glGenQueries( QUERY_LATENCY, m_Queries[ pass ] ) );
+		std::fill( m_QueryIssued[ pass ], m_QueryIssued[ pass ] + QUERY_LATENCY, false );
+	}
+}
+
+FrameProfiler::~FrameProfiler(){
+	for( int pass = 0; pass < ( int ) GpuPass::Count; pass++ ){
+		GLCall( glDeleteQueries( QUERY_LATENCY, m_Queries[ pass ] ) );
+	}
+}
+
+void FrameProfiler::NewFrame(){
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if( m_FrameStarted ){
+		m_FrameTime.Push( std::chrono::duration<float, std::milli>( now - m_FrameStart ).count() );
+		for( int section = 0; section < ( int ) CpuSection::Count; section++ )
+			m_Cpu[ section ].Push( m_CpuFrame[ section ] );
+
+		m_Triangles.Push( ( float ) RenderStats::GetTriangles() );
+		m_UploadedBytes.Push( ( float ) RenderStats::GetUploadedBytes() );
+	}
+
+	RenderStats::Reset();
+	std::fill( m_CpuFrame, m_CpuFrame + ( int ) CpuSection::Count, 0.0f );
+	m_FrameStart = now;
+	m_FrameStarted = true;
+
+	// The slot of this frame was last used QUERY_LATENCY frames ago, its results are read before it's reused
+	m_QueryFrame++;
+	ReadQueries( m_QueryFrame % QUERY_LATENCY );
+}
+
+void FrameProfiler::Begin( CpuSection section ){
+	m_CpuStart[ ( int ) section ] = std::chrono::steady_clock::now();
+}
+
+void FrameProfiler::End( CpuSection section ){
+	m_CpuFrame[ ( int ) section ] += std::chrono::duration<float, std::milli>( std::chrono::steady_clock::now() - m_CpuStart[ ( int ) section ] ).count();
+}
+
+void FrameProfiler::ReadQueries( int slot ){
+	for( int pass = 0; pass < ( int ) GpuPass::Count; pass++ ){
+		if( !m_QueryIssued[ pass ][ slot ] )
+			continue;
+		m_QueryIssued[ pass ][ slot ] = false;
+
+		// Never wait for the GPU, a result that isn't ready yet is dropped
+		GLint available = 0;
+		GLCall( glGetQueryObjectiv( m_Queries[ pass ][ slot ], GL_QUERY_RESULT_AVAILABLE, &available ) );
+		if( !available )
+			continue;
+
+		GLuint64 nanoseconds = 0;
+		GLCall( glGetQueryObjectui64v( m_Queries[ pass ][ slot ], GL_QUERY_RESULT, &nanoseconds ) );
+		m_Gpu[ pass ].Push( ( float ) ( nanoseconds / 1e6 ) );
+	}
+}
+
+void FrameProfiler::DrawPanel(){
+	ImGui::Begin( "Profiler" );
+
+	ImGui::SliderFloat( "Budget (ms)", &m_BudgetMs, 1.0f, 50.0f );
+
+	// Frame times as bars, red when over budget, with the budget as a line
+	float p99 = m_FrameTime.Percentile( 99.0f );
+	float top = std::max( m_BudgetMs * 1.5f, p99 * 1.1f );
+	ImVec2 size( ImGui::GetContentRegionAvailWidth(), 80.0f );
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImDrawList *draw = ImGui::GetWindowDrawList();
+	float barWidth = size.x / HISTORY;
+	int overBudget = 0;
+
+	draw->AddRectFilled( origin, ImVec2( origin.x + size.x, origin.y + size.y ), IM_COL32( 30, 30, 30, 255 ) );
+	for( size_t i = 0; i < m_FrameTime.GetSize(); i++ ){
+		float value = m_FrameTime.Get( i );
+		bool over = value > m_BudgetMs;
+		overBudget += over ? 1 : 0;
+
+		float height = std::min( value / top, 1.0f ) * size.y;
+		float x = origin.x + i * barWidth;
+		draw->AddRectFilled( ImVec2( x, origin.y + size.y - height ), ImVec2( x + std::max( barWidth - 1.0f, 1.0f ), origin.y + size.y ),
+			over ? IM_COL32( 230, 60, 60, 255 ) : IM_COL32( 90, 200, 90, 255 ) );
+	}
+	float budgetY = origin.y + size.y - m_BudgetMs / top * size.y;
+	draw->AddLine( ImVec2( origin.x, budgetY ), ImVec2( origin.x + size.x, budgetY ), IM_COL32( 255, 220, 0, 255 ) );
+	ImGui::Dummy( size );
+
+	ImGui::Text( "Frame  last %.3f  p50 %.3f  p95 %.3f  p99 %.3f ms", m_FrameTime.Last(),
+		m_FrameTime.Percentile( 50.0f ), m_FrameTime.Percentile( 95.0f ), p99 );
+	if( overBudget )
+		ImGui::TextColored( ImVec4( 0.9f, 0.25f, 0.25f, 1.0f ), "%d of the last %d frames over budget", overBudget, ( int ) m_FrameTime.GetSize() );
+	else
+		ImGui::Text( "No frame over budget" );
+
+	if( ImGui::CollapsingHeader( "CPU", ImGuiTreeNodeFlags_DefaultOpen ) ){
+		for( int section = 0; section < ( int ) CpuSection::Count; section++ )
+			DrawHistory( CPU_SECTION_NAMES[ section ], m_Cpu[ section ], "ms" );
+	}
+
+	if( ImGui::CollapsingHeader( "GPU", ImGuiTreeNodeFlags_DefaultOpen ) ){
+		for( int pass = 0; pass < ( int ) GpuPass::Count; pass++ )
+			DrawHistory( GPU_PASS_NAMES[ pass ], m_Gpu[ pass ], "ms" );
+	}
+
+	ImGui::Separator();
+	ImGui::Text( "Triangles drawn: %.0f", m_Triangles.Last() );
+	ImGui::Text( "Uploaded: %.1f KB last frame, %.1f KB p99", m_UploadedBytes.Last() / 1024.0f, m_UploadedBytes.Percentile( 99.0f ) / 1024.0f );
+
+	ImGui::End();
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include <GL/glew.h>
+
+// Parts of a frame timed on the CPU
+enum class CpuSection{
+	Input,
+	Uniforms,
+	Draw,
+	ImGui,
+	Swap,
+	Count
+};
+
+// Passes timed on the GPU with GL_TIME_ELAPSED queries
+enum class GpuPass{
+	Scene,
+	ImGui,
+	Count
+};
+
+// Last values of one measure, oldest first when read through Get
+class RollingHistory{
+private:
+	std::vector<float> m_Values;
+	size_t m_Next;
+	size_t m_Size;
+
+public:
+	RollingHistory( size_t capacity );
+
+	void Push( float value );
+	// @param index: 0 is the oldest value kept
+	float Get( size_t index ) const;
+	inline size_t GetSize() const{ return m_Size; }
+
+	// @param percentile: Between 0 and 100. @return 0 when empty
+	float Percentile( float percentile ) const;
+	float Last() const;
+};
+
+/**
+ * Rolling CPU and GPU timings of the last frames for the "Profiler" ImGui window.
+ * CPU sections can be entered several times per frame, their times add up. GPU queries are
+ * read a few frames later so the CPU never waits for them.
+ */
+class FrameProfiler{
+public:
+	static const size_t HISTORY = 240;
+	// Frames a GPU query has to finish before its result is read
+	static const int QUERY_LATENCY = 4;
+
+	// Adds the time until its destruction to the section
+	class CpuScope{
+	private:
+		FrameProfiler &m_Profiler;
+		CpuSection m_Section;
+
+	public:
+		CpuScope( FrameProfiler &profiler, CpuSection section );
+		~CpuScope();
+	};
+
+	// Times the pass on the GPU until its destruction, GPU scopes can't be nested
+	class GpuScope{
+	private:
+		FrameProfiler &m_Profiler;
+		GpuPass m_Pass;
+
+	public:
+		GpuScope( FrameProfiler &profiler, GpuPass pass );
+		~GpuScope();
+	};
+
+private:
+	std::vector<RollingHistory> m_Cpu;
+	std::vector<RollingHistory> m_Gpu;
+	RollingHistory m_FrameTime;
+	RollingHistory m_Triangles;
+	RollingHistory m_UploadedBytes;
+
+	float m_CpuFrame[ ( int ) CpuSection::Count ];
+	std::chrono::steady_clock::time_point m_CpuStart[ ( int ) CpuSection::Count ];
+	std::chrono::steady_clock::time_point m_FrameStart;
+	bool m_FrameStarted;
+
+	GLuint m_Queries[ ( int ) GpuPass::Count ][ QUERY_LATENCY ];
+	bool m_QueryIssued[ ( int ) GpuPass::Count ][ QUERY_LATENCY ];
+	int m_QueryFrame;
+
+	float m_BudgetMs;
+
+public:
+	// Needs a current GL context for the queries
+	FrameProfiler();
+	~FrameProfiler();
+
+	FrameProfiler( const FrameProfiler & ) = delete;
+	FrameProfiler &operator=( const FrameProfiler & ) = delete;
+
+	// Call once per frame before any scope, closes the previous frame
+	void NewFrame();
+
+	// Time a section that doesn't fit in a C++ scope, every Begin needs its End
+	void Begin( CpuSection section );
+	void End( CpuSection section );
+
+	// The "Profiler" window, frames slower than the budget are drawn in red
+	void DrawPanel();
+
+	inline const RollingHistory &GetFrameTime() const{ return m_FrameTime; }
+	inline const RollingHistory &GetCpu( CpuSection section ) const{ return m_Cpu[ ( int ) section ]; }
+	inline const RollingHistory &GetGpu( GpuPass pass ) const{ return m_Gpu[ ( int ) pass ]; }
+
+private:
+	void ReadQueries( int slot );
+};
@@ -0,0 +1,177 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <fstream>
+#include <vector>
+
+namespace{
+
+std::vector<uint32_t> MakeCrcTable(){
+	std::vector<uint32_t> table( 256 );
+	for( uint32_t n = 0; n < 256; n++ ){
+		uint32_t c = n;
+		for( int k = 0; k < 8; k++ )
+			c = ( c & 1 ) ? 0xEDB88320u ^ ( c >> 1 ) : c >> 1;
+		table[ n ] = c;
+	}
+	return table;
+}
+
+uint32_t Crc32( const uint8_t *data, size_t size, uint32_t crc = 0 ){
+	// Frames can be written from several threads, the static is initialized once
+	static const std::vector<uint32_t> table = MakeCrcTable();
+
+	crc = ~crc;
+	for( size_t i = 0; i < size; i++ )
+		crc = table[ ( crc ^ data[ i ] ) & 0xFF ] ^ ( crc >> 8 );
+	return ~crc;
+}
+
+void PushBigEndian( std::vector<uint8_t> &out, uint32_t value ){
+	out.push_back( ( uint8_t ) ( value >> 24 ) );
+	out.push_back( ( uint8_t ) ( value >> 16 ) );
+	out.push_back( ( uint8_t ) ( value >> 8 ) );
+	out.push_back( ( uint8_t ) value );
+}
+
+void PushChunk( std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data ){
+	PushBigEndian( out, ( uint32_t ) data.size() );
+
+	size_t start = out.size();
+	out.insert( out.end(), type, type + 4 );
+	out.insert( out.end(), data.begin(), data.end() );
+
+	PushBigEndian( out, Crc32( out.data() + start, out.size() - start ) );
+}
+
+}
+
+bool ImageWriter::WritePNG( const std::string &path, const uint8_t *rgba, int width, int height ){
+	// Every row starts with filter type 0 ( none )
+	size_t rowSize = ( size_t ) width * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve( ( rowSize + 1 ) * height );
+	for( int y = 0; y < height; y++ ){
+		raw.push_back( 0 );
+		raw.insert( raw.end(), rgba + y * rowSize, rgba + ( y + 1 ) * rowSize );
+	}
+
+	// zlib stream made of stored deflate blocks
+	std::vector<uint8_t> zlib = { 0x78, 0x01 };
+	size_t offset = 0;
+	do{
+		size_t length = std::min<size_t>( raw.size() - offset, 65535 );
+		bool last = offset + length == raw.size();
+
+		zlib.push_back( last ? 1 : 0 );
+		zlib.push_back( ( uint8_t ) length );
+		zlib.push_back( ( uint8_t ) ( length >> 8 ) );
+		zlib.push_back( ( uint8_t ) ~length );
+		zlib.push_back( ( uint8_t ) ( ~length >> 8 ) );
+		zlib.insert( zlib.end(), raw.begin() + offset, raw.begin() + offset + length );
+
+		offset += length;
+	} while( offset < raw.size() );
+
+	uint32_t a = 1, b = 0;
+	for( uint8_t byte : raw ){
+		a = ( a + byte ) % 65521;
+		b = ( b + a ) % 65521;
+	}
+	PushBigEndian( zlib, ( b << 16 ) | a );
+
+	std::vector<uint8_t> header;
+	PushBigEndian( header, width );
+	PushBigEndian( header, height );
+	// 8 bits per channel, color type 6 ( RGBA ), deflate, no filter, no interlace
+	header.insert( header.end(), { 8, 6, 0, 0, 0 } );
+
+	std::vector<uint8_t> file = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	PushChunk( file, "IHDR", header );
+	PushChunk( file, "IDAT", zlib );
+	PushChunk( file, "IEND", std::vector<uint8_t>() );
+
+	std::ofstream stream( path, std::ios::binary );
+	stream.write( ( const char * ) file.data(), file.size() );
+	return stream.good();
+}
+
+bool ImageWriter::WritePPM( const std::string &path, const uint8_t *rgba, int width, int height ){
+	std::ofstream stream( path, std::ios::binary );
+	stream << "P6\n" << width << " " << height << "\n255\n";
+
+	std::vector<uint8_t> rgb( ( size_t ) width * height * 3 );
+	for( size_t i = 0; i < ( size_t ) width * height; i++ ){
+		rgb[ i * 3 ] = rgba[ i * 4 ];
+		rgb[ i * 3 + 1 ] = rgba[ i * 4 + 1 ];
+		rgb[ i * 3 + 2 ] = rgba[ i * 4 + 2 ];
+	}
+
+	stream.write( ( const char * ) rgb.data(), rgb.size() );
+	return stream.good();
+}
+
+bool ImageWriter::Write( const std::string &path, const uint8_t *rgba, int width, int height ){
+	if( path.size() >= 4 && path.compare( path.size() - 4, 4, ".ppm" ) == 0 )
+		return WritePPM( path, rgba, width, height );
+
+	return WritePNG( path, rgba, width, height );
+}
+
+Y4MWriter::Y4MWriter( const std::string &path, int width, int height, int fps )
+	: m_File( nullptr ), m_Width( width ), m_Height( height ){
+	m_File = path == "-" ? stdout : fopen( path.c_str(), "wb" );
+	if( m_File )
+		fprintf( m_File, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps );
+}
+
+Y4MWriter::~Y4MWriter(){
+	if( m_File && m_File != stdout )
+		fclose( m_File );
+	else if( m_File )
+		fflush( m_File );
+}
+
+bool Y4MWriter::WriteFrame( const uint8_t *rgba ){
+	if( !m_File )
+		return false;
+
+	int chromaWidth = ( m_Width + 1 ) / 2, chromaHeight = ( m_Height + 1 ) / 2;
+	size_t lumaSize = ( size_t ) m_Width * m_Height, chromaSize = ( size_t ) chromaWidth * chromaHeight;
+	m_Planes.resize( lumaSize + chromaSize * 2 );
+	uint8_t *yPlane = m_Planes.data();
+	uint8_t *uPlane = yPlane + lumaSize;
+	uint8_t *vPlane = uPlane + chromaSize;
+
+	for( size_t i = 0; i < lumaSize; i++ ){
+		const uint8_t *p = rgba + i * 4;
+		yPlane[ i ] = ( uint8_t ) std::min( 255.0f, 0.299f * p[ 0 ] + 0.587f * p[ 1 ] + 0.114f * p[ 2 ] + 0.5f );
+	}
+
+	// Chroma is the average of each 2x2 block
+	for( int cy = 0; cy < chromaHeight; cy++ ){
+		for( int cx = 0; cx < chromaWidth; cx++ ){
+			float r = 0.0f, g = 0.0f, b = 0.0f;
+			int samples = 0;
+			for( int y = cy * 2; y < std::min( cy * 2 + 2, m_Height ); y++ ){
+				for( int x = cx * 2; x < std::min( cx * 2 + 2, m_Width ); x++ ){
+					const uint8_t *p = rgba + ( ( size_t ) y * m_Width + x ) * 4;
+					r += p[ 0 ];
+					g += p[ 1 ];
+					b += p[ 2 ];
+					samples++;
+				}
+			}
+			r /= samples;
+			g /= samples;
+			b /= samples;
+
+			size_t index = ( size_t ) cy * chromaWidth + cx;
+			uPlane[ index ] = ( uint8_t ) std::max( 0.0f, std::min( 255.0f, 128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b + 0.5f ) );
+			vPlane[ index ] = ( uint8_t ) std::max( 0.0f, std::min( 255.0f, 128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b + 0.5f ) );
+		}
+	}
+
+	fputs( "FRAME\n", m_File );
+	return fwrite( m_Planes.data(), 1, m_Planes.size(), m_File ) == m_Planes.size();
+}
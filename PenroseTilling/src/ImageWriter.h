@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writers for 8 bit RGBA images with the first row at the top, no compression library needed
+class ImageWriter{
+public:
+	// PNG with stored ( uncompressed ) deflate blocks, alpha is kept. @return false if the file can't be written
+	static bool WritePNG( const std::string &path, const uint8_t *rgba, int width, int height );
+
+	// Binary PPM ( P6 ), alpha is dropped
+	static bool WritePPM( const std::string &path, const uint8_t *rgba, int width, int height );
+
+	// PPM when path ends with .ppm, PNG otherwise. @return false if the file can't be written
+	static bool Write( const std::string &path, const uint8_t *rgba, int width, int height );
+};
+
+// Raw YUV4MPEG2 stream, 4:2:0 with full range BT.601 ( C420jpeg ), frames are appended in order
+class Y4MWriter{
+private:
+	FILE *m_File;
+	int m_Width;
+	int m_Height;
+	std::vector<uint8_t> m_Planes;
+
+public:
+	/**
+	 * @param path: Output file, "-" writes to stdout
+	 * @param width, height: Size of every frame
+	 * @param fps: Frame rate stored in the header
+	 */
+	Y4MWriter( const std::string &path, int width, int height, int fps );
+	~Y4MWriter();
+
+	Y4MWriter( const Y4MWriter & ) = delete;
+	Y4MWriter &operator=( const Y4MWriter & ) = delete;
+
+	inline bool IsOpen() const{ return m_File != nullptr; }
+
+	// @return false if the frame can't be written
+	bool WriteFrame( const uint8_t *rgba );
+};
@@ -1,20 +1,32 @@
 #include "IndexBuffer.h"
 #include "Renderer.h"
 
-IndexBuffer::IndexBuffer( const unsigned int *data, unsigned int count )
-	: m_Count(count){
+IndexBuffer::IndexBuffer( const unsigned int *data, unsigned int count, unsigned int usage )
+	: m_Count( count ), m_Capacity( count ), m_Usage( usage ){
 
 	ASSERT( sizeof( unsigned int ) == sizeof( GLuint ) );
 
 	GLCall( glGenBuffers( 1, &m_RenderID ) );
 	GLCall( glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_RenderID ) );
-	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW))
+	GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, usage))
+	RenderStats::AddUploadedBytes( count * sizeof( unsigned int ) );
 }
 
 IndexBuffer::~IndexBuffer(){
 	GLCall( glDeleteBuffers( 1, &m_RenderID ) );
 }
 
+void IndexBuffer::SetData( const unsigned int *data, unsigned int count ){
+	if( count > m_Capacity )
+		m_Capacity = count + count / 2;
+
+	Bind();
+	GLCall( glBufferData( GL_ELEMENT_ARRAY_BUFFER, m_Capacity * sizeof( unsigned int ), nullptr, m_Usage ) );
+	GLCall( glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, 0, count * sizeof( unsigned int ), data ) );
+	RenderStats::AddUploadedBytes( count * sizeof( unsigned int ) );
+	m_Count = count;
+}
+
 void IndexBuffer::Bind() const{
 	GLCall( glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_RenderID ) );
 }
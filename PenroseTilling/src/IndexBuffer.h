@@ -1,17 +1,27 @@
 #pragma once
 
+#include <GL/glew.h>
+
 class IndexBuffer{
 
 private:
 	unsigned int m_RenderID;
 	unsigned int m_Count;
+	// Indices the storage holds, at least m_Count
+	unsigned int m_Capacity;
+	unsigned int m_Usage;
 
 public:
-	IndexBuffer( const unsigned int *data, unsigned int count );
+	// @param usage: GL_STATIC_DRAW, or GL_DYNAMIC_DRAW for a buffer that SetData will replace
+	IndexBuffer( const unsigned int *data, unsigned int count, unsigned int usage = GL_STATIC_DRAW );
 	~IndexBuffer();
 
+	// Replace the indices, growing and orphaning the storage like VertexBuffer::SetData
+	void SetData( const unsigned int *data, unsigned int count );
+
 	void Bind() const;
 	void UnBind() const;
 
 	inline unsigned int GetCount() const{ return m_Count; }
-};
\ No newline at end of file
+	inline unsigned int GetCapacity() const{ return m_Capacity; }
+};
@@ -0,0 +1,154 @@
+#include "InstancedTilling.h"
+
+#include <cmath>
+
+#include "Profiler.h"
+#include "VertexBufferLayout.h"
+
+static_assert( sizeof( TileInstance ) == VertexStride<TileInstanceFormat>(), "TileInstance must match TileInstanceFormat" );
+
+// Radians the streamed tiles sway to each side
+static const float SWAY = 0.05f;
+
+void InstancedTilling::Upload( const Penrose &tilling, float extrusionHeight, Arena &arena, bool streamed ){
+	UploadMeshes( 0, extrusionHeight, streamed, arena,
+		[ & ]( int type ){ return tilling.GetNumTilesOfType( type ); },
+		[ & ]( int type, Span<TileInstance> out ){ tilling.WriteInstances( type, out ); } );
+}
+
+void InstancedTilling::Upload( const SubstitutionDag &dag, int prototypeDepth, float extrusionHeight, Arena &arena, bool streamed ){
+	UploadMeshes( prototypeDepth, extrusionHeight, streamed, arena,
+		[ & ]( int type ){ return ( size_t ) dag.GetNumInstances( type, prototypeDepth ); },
+		[ & ]( int type, Span<TileInstance> out ){ dag.ExpandInstances( type, prototypeDepth, out ); } );
+}
+
+template<typename CountInstances, typename WriteInstances>
+void InstancedTilling::UploadMeshes( int prototypeDepth, float extrusionHeight, bool streamed, Arena &arena, CountInstances countInstances, WriteInstances writeInstances ){
+	PROFILE_SCOPE( "InstancedTilling::Upload" );
+	const VertexBufferLayout prototypeLayout = VertexBufferLayout::FromFormat<TileFormat>();
+	const VertexBufferLayout instanceLayout = VertexBufferLayout::FromFormat<TileInstanceFormat>();
+
+	for( int type = 1; type <= 2; type++ ){
+		Mesh &mesh = m_Meshes[ type - 1 ];
+
+		// No tile of the type, like type 2 before the first deflate, and GL takes no empty storage
+		size_t count = countInstances( type );
+		mesh.count = ( unsigned int ) count;
+		if( !count )
+			continue;
+
+		// Same pyramids as DoIt3D builds for every tile, the shader only scales them in the plane of the tilling
+		Penrose prototype( Triangle::Prototype( type ), prototypeDepth, &arena );
+		prototype.execute();
+		if( extrusionHeight != 0.0f )
+			prototype.DoIt3D( extrusionHeight );
+
+		size_t numBytes = prototype.GetVertexBytes<TileFormat>();
+		unsigned char *vertices = arena.AllocateArray<unsigned char>( numBytes );
+		prototype.PackVertices<TileFormat>( Span<unsigned char>( vertices, numBytes ), 1 );
+
+		// In order, the shader takes the corner from gl_VertexID
+		unsigned int numIndices = prototype.GetNumTriangles() * 3;
+		unsigned int *indices = arena.AllocateArray<unsigned int>( numIndices );
+		for( unsigned int i = 0; i < numIndices; i++ )
+			indices[ i ] = i;
+
+		// Orphaned and refilled when they exist, the vertex array keeps pointing at the same buffers
+		if( mesh.prototype )
+			mesh.prototype->SetData( vertices, ( unsigned int ) numBytes );
+		else
+			mesh.prototype.reset( new VertexBuffer( vertices, ( unsigned int ) numBytes, GL_DYNAMIC_DRAW ) );
+		if( mesh.indices )
+			mesh.indices->SetData( indices, numIndices );
+		else
+			mesh.indices.reset( new IndexBuffer( indices, numIndices, GL_DYNAMIC_DRAW ) );
+		mesh.va.AddBuffer( *mesh.prototype, prototypeLayout );
+
+		const unsigned int instanceBytes = ( unsigned int ) ( count * sizeof( TileInstance ) );
+		const unsigned int firstLocation = ( unsigned int ) prototypeLayout.GetElements().size();
+		if( streamed ){
+			mesh.instances.reset();
+			mesh.base.resize( count );
+			writeInstances( type, Span<TileInstance>( mesh.base.data(), count ) );
+			if( !mesh.ring || mesh.ring->GetSectionSize() < instanceBytes )
+				mesh.ring.reset( new VertexBufferRing( instanceBytes ) );
+			// Every section at once, the draws pick theirs with the base instance
+			mesh.va.AddBuffer( mesh.ring->GetBuffer(), instanceLayout, firstLocation, 1 );
+		}
+		else{
+			mesh.ring.reset();
+			std::vector<TileInstance>().swap( mesh.base );
+			// Map waits for the draws of the old instances before they are overwritten
+			if( !mesh.instances || mesh.instances->GetCapacity() < instanceBytes )
+				mesh.instances.reset( new VertexBuffer( instanceBytes ) );
+			// Written in place in the mapped storage, the instances never exist on the host
+			writeInstances( type, Span<TileInstance>( static_cast< TileInstance * >( mesh.instances->Map() ), count ) );
+			RenderStats::AddUploadedBytes( instanceBytes );
+			mesh.va.AddBuffer( *mesh.instances, instanceLayout, firstLocation, 1 );
+		}
+	}
+	m_Meshes[ 0 ].va.UnBind();
+}
+
+void InstancedTilling::Clear(){
+	for( Mesh &mesh : m_Meshes ){
+		mesh.prototype.reset();
+		mesh.indices.reset();
+		mesh.instances.reset();
+		mesh.ring.reset();
+		std::vector<TileInstance>().swap( mesh.base );
+		mesh.count = 0;
+	}
+}
+
+void InstancedTilling::Stream( float time ){
+	PROFILE_SCOPE( "InstancedTilling::Stream" );
+	for( Mesh &mesh : m_Meshes ){
+		if( !mesh.ring || !mesh.count )
+			continue;
+
+		TileInstance *out = static_cast< TileInstance * >( mesh.ring->Begin() );
+		for( unsigned int i = 0; i < mesh.count; i++ ){
+			TileInstance instance = mesh.base[ i ];
+			// Out of phase across the tilling, so the sway runs over it as a wave
+			instance.rotation += SWAY * std::sin( 2.0f * time + 5.0f * instance.x + 3.0f * instance.y );
+			out[ i ] = instance;
+		}
+		RenderStats::AddUploadedBytes( mesh.count * sizeof( TileInstance ) );
+	}
+}
+
+void InstancedTilling::Draw( const Renderer &renderer, const Shader &shader ){
+	for( Mesh &mesh : m_Meshes ){
+		if( !mesh.count )
+			continue;
+
+		if( mesh.ring ){
+			renderer.DrawInstanced( mesh.va, *mesh.indices, shader, mesh.count, mesh.ring->GetOffset() / sizeof( TileInstance ) );
+			mesh.ring->End();
+		}
+		else{
+			renderer.DrawInstanced( mesh.va, *mesh.indices, shader, mesh.count );
+			mesh.instances->Fence();
+		}
+	}
+}
+
+size_t InstancedTilling::GetBytes() const{
+	size_t bytes = 0;
+	for( const Mesh &mesh : m_Meshes ){
+		if( mesh.indices )
+			bytes += mesh.indices->GetCount() * ( sizeof( unsigned int ) + VertexStride<TileFormat>() );
+		// Streamed, every section of the ring
+		bytes += mesh.count * sizeof( TileInstance ) * ( mesh.ring ? VertexBufferRing::SECTIONS : 1 );
+	}
+	return bytes;
+}
+
+size_t InstancedTilling::GetNumInstances() const{
+	return m_Meshes[ 0 ].count + m_Meshes[ 1 ].count;
+}
+
+std::string InstancedTilling::GetVertexInputs(){
+	return GlslVertexInputs<TileFormat>() + GlslVertexInputs<TileInstanceFormat>( ( unsigned int ) std::size( TileFormat::ATTRIBUTES ) );
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arena.h"
+#include "IndexBuffer.h"
+#include "Penrose.h"
+#include "Renderer.h"
+#include "SubstitutionDag.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VertexBufferRing.h"
+
+/*
+ * The tilling drawn with one glDrawElementsInstanced per tile type. The prototype of the type, flat or
+ * extruded like Penrose::DoIt3D, is stored once in TileFormat and every tile is a TileInstance of 16 bytes
+ * that the vertex shader places it with ( HAS_INSTANCE in project.shader ), instead of 3 whole vertices.
+ *
+ * The prototypes can be supertiles of a SubstitutionDag, the tile deflated a few times, and then only the
+ * levels above them are expanded into instances.
+ *
+ * Uploading again reuses the buffers, grown when needed. Streamed, the instances are kept on the host and
+ * Stream moves them every frame into a VertexBufferRing, so the GPU never waits for the upload nor the CPU
+ * for the draws.
+ */
+class InstancedTilling{
+private:
+	struct Mesh{
+		VertexArray va;
+		std::unique_ptr<VertexBuffer> prototype;
+		std::unique_ptr<IndexBuffer> indices;
+		// Written once per upload, or every frame through the ring when streamed
+		std::unique_ptr<VertexBuffer> instances;
+		std::unique_ptr<VertexBufferRing> ring;
+		// Placements the streamed instances move from
+		std::vector<TileInstance> base;
+		unsigned int count = 0;
+	};
+
+	// Tile types 1 and 2
+	Mesh m_Meshes[ 2 ];
+
+	// countInstances( type ) returns the instances of the type and writeInstances( type, out ) writes them
+	template<typename CountInstances, typename WriteInstances>
+	void UploadMeshes( int prototypeDepth, float extrusionHeight, bool streamed, Arena &arena, CountInstances countInstances, WriteInstances writeInstances );
+
+public:
+	/**
+	 * Upload the prototypes and the instances of a tilling
+	 *
+	 * @param tilling: Flat tilling, before DoIt3D or Rotate
+	 * @param extrusionHeight: Height of the pyramids of Penrose::DoIt3D, 0 for flat tiles
+	 * @param streamed: Keep the instances for Stream instead of writing them once
+	 * @param arena: Where the buffers are built before the upload
+	 */
+	void Upload( const Penrose &tilling, float extrusionHeight, Arena &arena, bool streamed = false );
+
+	/**
+	 * Same from the DAG of a tilling, with the supertiles of a depth as prototypes
+	 *
+	 * @param prototypeDepth: Levels deflated in the prototypes, up to dag.GetDepth(). The prototypes grow
+	 * and the instances shrink by about 2.6 times per level
+	 */
+	void Upload( const SubstitutionDag &dag, int prototypeDepth, float extrusionHeight, Arena &arena, bool streamed = false );
+	// Release the buffers
+	void Clear();
+
+	/**
+	 * Write the instances of a new frame, every tile swaying around its placement. Nothing for
+	 * a tilling that wasn't uploaded streamed
+	 *
+	 * @param time: Seconds since the start
+	 */
+	void Stream( float time );
+	// Fences the instances it reads, for the next Upload or Stream
+	void Draw( const Renderer &renderer, const Shader &shader );
+
+	// @return the bytes of the prototypes and the instances held by GL
+	size_t GetBytes() const;
+	// @return the instances of both types
+	size_t GetNumInstances() const;
+	inline bool IsStreamed() const{ return m_Meshes[ 0 ].ring || m_Meshes[ 1 ].ring; }
+
+	// @return the inputs of the vertex shader, TileFormat and then TileInstanceFormat
+	static std::string GetVertexInputs();
+};
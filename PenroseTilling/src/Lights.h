@@ -0,0 +1,104 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#define NR_POINT_LIGHTS 4
+
+// Same structs and members as the uniforms of the fragment stage in project.shader
+
+struct Material{
+	glm::vec3 specular;
+	float shininess;
+};
+
+struct DirLight{
+	glm::vec3 direction;
+
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+};
+
+struct PointLight{
+	glm::vec3 position;
+
+	float constant;
+	float linear;
+	float quadratic;
+
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+};
+
+struct SpotLight{
+	glm::vec3 position;
+	glm::vec3 direction;
+	float cutOff;
+	float outerCutOff;
+
+	float constant;
+	float linear;
+	float quadratic;
+
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+};
+
+struct SceneLights{
+	glm::vec3 viewPos;
+	Material material;
+	DirLight dirLight;
+	PointLight pointLights[ NR_POINT_LIGHTS ];
+	SpotLight spotLight;
+
+	/**
+	 * The lights the application starts with, the spot light follows the camera
+	 *
+	 * @param cameraPosition: Position of the camera, also the spot light position
+	 * @param cameraFront: Direction the camera looks at, also the spot light direction
+	 */
+	static SceneLights Default( glm::vec3 cameraPosition, glm::vec3 cameraFront ){
+		SceneLights lights;
+		lights.viewPos = cameraPosition;
+
+		lights.material.specular = glm::vec3( 0.2f, 0.2f, 0.2f );
+		lights.material.shininess = 45.0f;
+
+		lights.dirLight.direction = glm::vec3( 0.0f, 0.0f, 5.0f );
+		lights.dirLight.ambient = glm::vec3( 0.05f, 0.05f, 0.05f );
+		lights.dirLight.diffuse = glm::vec3( 0.9f, 0.9f, 0.9f );
+		lights.dirLight.specular = glm::vec3( 0.5f, 0.5f, 0.5f );
+
+		const glm::vec3 pointLightPositions[ NR_POINT_LIGHTS ] = {
+			glm::vec3( 2.7f,  2.2f,  2.0f ),
+			glm::vec3( 2.3f, -3.3f, -4.0f ),
+			glm::vec3( -4.0f,  2.0f, -10.0f ),
+			glm::vec3( 3.0f,  3.0f, -3.0f )
+		};
+		for( int i = 0; i < NR_POINT_LIGHTS; i++ ){
+			PointLight &light = lights.pointLights[ i ];
+			light.position = pointLightPositions[ i ];
+			light.ambient = glm::vec3( 0.05f, 0.05f, 0.05f );
+			light.diffuse = glm::vec3( 0.8f, 0.8f, 0.8f );
+			light.specular = glm::vec3( 1.0f, 1.0f, 1.0f );
+			light.constant = 1.0f;
+			light.linear = 0.09f;
+			light.quadratic = 0.032f;
+		}
+
+		lights.spotLight.position = cameraPosition;
+		lights.spotLight.direction = cameraFront;
+		lights.spotLight.ambient = glm::vec3( 0.0f, 0.0f, 0.0f );
+		lights.spotLight.diffuse = glm::vec3( 1.0f, 1.0f, 1.0f );
+		lights.spotLight.specular = glm::vec3( 1.0f, 1.0f, 1.0f );
+		lights.spotLight.constant = 1.0f;
+		lights.spotLight.linear = 0.09f;
+		lights.spotLight.quadratic = 0.032f;
+		lights.spotLight.cutOff = glm::cos( glm::radians( 12.5f ) );
+		lights.spotLight.outerCutOff = glm::cos( glm::radians( 15.0f ) );
+
+		return lights;
+	}
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// @return the number of hardware threads, never less than 1
+inline unsigned int HardwareThreads(){
+	unsigned int threads = std::thread::hardware_concurrency();
+	return threads ? threads : 1;
+}
+
+// @return how many chunks ParallelFor will split count items into ( 0 threads means one per hardware thread )
+inline unsigned int ParallelChunks( size_t count, unsigned int threads ){
+	if( threads == 0 )
+		threads = HardwareThreads();
+	if( count < threads )
+		threads = ( unsigned int ) std::max<size_t>( count, 1 );
+	return threads;
+}
+
+/**
+ * Split [0, count) into contiguous chunks and run fn( begin, end, chunk ) for each one.
+ * The calling thread takes the last chunk, so a single chunk never spawns a thread.
+ *
+ * @param count: Number of items to process
+ * @param threads: Number of workers, 0 for one per hardware thread
+ * @param fn: Callable with signature void( size_t begin, size_t end, unsigned int chunk )
+ */
+template<typename Func>
+void ParallelFor( size_t count, unsigned int threads, Func fn ){
+	unsigned int chunks = ParallelChunks( count, threads );
+	size_t step = count / chunks;
+	size_t extra = count % chunks;
+
+	std::vector<std::thread> workers;
+	workers.reserve( chunks - 1 );
+
+	size_t begin = 0;
+	for( unsigned int i = 0; i < chunks; i++ ){
+		size_t end = begin + step + ( i < extra ? 1 : 0 );
+
+		if( i + 1 == chunks )
+			fn( begin, end, i );
+		else
+			workers.emplace_back( fn, begin, end, i );
+
+		begin = end;
+	}
+
+	for( std::thread &worker : workers )
+		worker.join();
+}
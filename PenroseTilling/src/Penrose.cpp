@@ -1,6 +1,9 @@
 #include "Penrose.h"
 #include <iostream>
 
+#include "Parallel.h"
+#include "Profiler.h"
+
 /**
  * Constructor of Penrose Class
  *
@@ -8,20 +11,29 @@
  * @param _origin: First coordinate for do a triangle
  * @param _degree: Just 36 degrees or 108 degrees
  * @param _height: The height of the tringle
+ * @param _arena: Where the buffers of the tilling are allocated, null for the heap
  *
  */
-Penrose::Penrose( int _loops, Coordinate _origin, int _degree, float _height ){
+template<typename T>
+PenroseT<T>::PenroseT( int _loops, CoordinateT<T> _origin, int _degree, float _height, Arena *_arena )
+	: arena( _arena ), triangles( ArenaAllocator<TriangleT<T>>( _arena ) ), normals( ArenaAllocator<glm::vec3>( _arena ) ){
 	loops = _loops;
+	degree = _degree;
+	height = _height;
 	int totalTriangles = 360 / _degree;
+	triangles.reserve( totalTriangles );
+
+	// Same rotation for every seed triangle, built once
+	Rotation3D rotation( Axis::Z, _degree, _origin.ToDVec3() );
+	//Rotation3D rotation( Axis::YZ, -_degree, glm::dvec3( 0.0 ) );
 
-	Coordinate p = Coordinate( _height, 0 );
+	CoordinateT<T> p = CoordinateT<T>( T( _height ), T( 0.0 ) );
 	for( int i = 0; i < totalTriangles; i++ ){
-		Coordinate temp = Coordinate::RotatePoint( _origin, _degree, p );
-		//Coordinate temp = Coordinate::RotatePoint3D( _origin, _degree, p, "YZ");
+		CoordinateT<T> temp = rotation.Apply( p );
 		if( i % 2 == 0 ){
-			triangles.push_back( Triangle( _origin, p, temp, 0 ) );
+			triangles.push_back( TriangleT<T>( _origin, p, temp, 0 ) );
 		} else{
-			triangles.push_back( Triangle( _origin, temp, p, 0 ) );
+			triangles.push_back( TriangleT<T>( _origin, temp, p, 0 ) );
 		}
 		p = temp;
 	}
@@ -29,53 +41,77 @@ Penrose::Penrose( int _loops, Coordinate _origin, int _degree, float _height ){
 	NumTriangles = triangles.size();
 }
 
+template<typename T>
+PenroseT<T>::PenroseT( const TriangleT<T> &tile, int _loops, Arena *_arena )
+	: arena( _arena ), triangles( 1, tile, ArenaAllocator<TriangleT<T>>( _arena ) ), normals( ArenaAllocator<glm::vec3>( _arena ) ){
+	loops = _loops;
+	degree = 0;
+	height = 1.0f;
+	NumTriangles = triangles.size();
+}
+
 /*
  * Clear the triangles vector
  */
-Penrose::~Penrose(){
+template<typename T>
+PenroseT<T>::~PenroseT(){
 	triangles.clear();
 }
 
-void Penrose::execute(){
+template<typename T>
+void PenroseT<T>::execute(){
+	PROFILE_SCOPE( "Penrose::execute" );
 	for( int i = 0; i < loops; i++ )
 		triangles = deflate();
 
+	// Deflating invalidates the normals of a previous DoIt3D
+	normals.clear();
+
 	NumTriangles = triangles.size();
+	PROFILE_COUNTER( "triangles", NumTriangles );
 }
 
 /**
  * Create the deflate around the principal triangle
  */
-std::vector<Triangle> Penrose::deflate(){
-	std::vector<Triangle> temp;
-
-	for( const Triangle &t : triangles ){
+template<typename T>
+TriangleList<T> PenroseT<T>::deflate(){
+	PROFILE_SCOPE( "Penrose::deflate" );
+	TriangleList<T> temp( triangles.get_allocator() );
+
+	// Sized once, growing would leave every outgrown buffer behind in the arena
+	size_t count = 0;
+	for( const TriangleT<T> &t : triangles )
+		count += t.type == 2 ? 3 : t.type == 1 ? 2 : 0;
+	temp.reserve( count );
+
+	for( const TriangleT<T> &t : triangles ){
 		if( t.type == 2 ){
 
 			// B + ( ( A - B) / PHI )
-			Coordinate Q = Coordinate::sum(
+			CoordinateT<T> Q = CoordinateT<T>::sum(
 				t.b, 
-				Coordinate::divide(	Coordinate::diff( t.a, t.b ), PHI ) 
+				CoordinateT<T>::divide(	CoordinateT<T>::diff( t.a, t.b ), PHI ) 
 			);
 			// B + ( ( C - B) / PHI )
-			Coordinate R = Coordinate::sum( 
+			CoordinateT<T> R = CoordinateT<T>::sum( 
 				t.b, 
-				Coordinate::divide( Coordinate::diff( t.c, t.b ), PHI )
+				CoordinateT<T>::divide( CoordinateT<T>::diff( t.c, t.b ), PHI )
 			);
 
-			temp.push_back( Triangle( R, t.c, t.a, 1 ) );
-			temp.push_back( Triangle( Q, R, t.b, 1 ) );
-			temp.push_back( Triangle( R, Q, t.a, 0 ) );
+			temp.push_back( TriangleT<T>( R, t.c, t.a, 1 ) );
+			temp.push_back( TriangleT<T>( Q, R, t.b, 1 ) );
+			temp.push_back( TriangleT<T>( R, Q, t.a, 0 ) );
 
 		} else if( t.type == 1 ){
 
-			Coordinate P = Coordinate::sum(
+			CoordinateT<T> P = CoordinateT<T>::sum(
 				t.a,
-				Coordinate::divide( Coordinate::diff( t.b, t.a ), PHI )
+				CoordinateT<T>::divide( CoordinateT<T>::diff( t.b, t.a ), PHI )
 			);
 
-			temp.push_back( Triangle( t.c, P, t.b, 0 ) );
-			temp.push_back( Triangle( P, t.c, t.a, 1 ) );
+			temp.push_back( TriangleT<T>( t.c, P, t.b, 0 ) );
+			temp.push_back( TriangleT<T>( P, t.c, t.a, 1 ) );
 
 		}
 	}
@@ -83,138 +119,169 @@ std::vector<Triangle> Penrose::deflate(){
 	return temp;
 }
 
-void Penrose::DoIt3D(){
-	std::vector<Triangle> temp = DoIT3D();
-
-	for( const Triangle &t : temp ){
-		triangles.push_back( t );
-
-		NumTriangles++;
-	}
-}
-
-std::vector<Triangle> Penrose::DoIT3D(){
-	std::vector<Triangle> temp;
-
-	for( Triangle &t : triangles ){
-		glm::vec3 origin = glm::vec3( t.a.x, t.a.y, t.a.z );
-		glm::vec3 Normalized_Vector = t.GetNormalOfTriangle();
-		glm::vec3 top_point = origin + ( Normalized_Vector );
-
-		temp.push_back(
-			Triangle(
-				Coordinate( top_point.x, top_point.y, top_point.z ),
-				t.b,
-				t.a,
-				t.type - 1
-			)
-		);
-		temp.push_back(
-			Triangle(
-				Coordinate( top_point.x, top_point.y, top_point.z ),
-				t.a,
-				t.c,
-				t.type - 1
-			)
-		);
-		temp.push_back(
-			Triangle(
-				Coordinate( top_point.x, top_point.y, top_point.z ),
-				t.c,
-				t.b,
-				t.type - 1
-			)
-		);
-	}
-
-	return temp;
-}
-
-float *Penrose::GetVertices(){
-	int vectorSize = NumTriangles * 9;
-	float *vertices = new float[ vectorSize ];
-
-	int i = 0;
-	for( Triangle t : triangles ){
-		float *triangleVertices = t.getTriangleCoordinates();
-
-		for( int j = 0; j < 9; j++ ){
-			vertices[ i ] = triangleVertices[ j ];
-			i++;
+/**
+ * Turn every triangle into a pyramid, adding 3 side faces per triangle after the current ones.
+ * The output is sized once ( 4 times the input ) and every worker writes its own faces and normals in place.
+ *
+ * @param extrusionHeight: Distance from the base to the apex along the normal of the triangle
+ * @param apex: Point of the base the apex is raised from
+ * @param threads: Number of workers, 0 for one per hardware thread
+ */
+template<typename T>
+void PenroseT<T>::DoIt3D( float extrusionHeight, ExtrusionApex apex, unsigned int threads ){
+	PROFILE_SCOPE( "Penrose::DoIt3D" );
+	const size_t count = triangles.size();
+
+	triangles.resize( count * 4 );
+	normals.resize( count * 4 );
+
+	ParallelFor( count, threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		for( size_t i = begin; i < end; i++ ){
+			const TriangleT<T> &t = triangles[ i ];
+			glm::vec3 Normalized_Vector = t.GetNormalOfTriangle();
+			normals[ i ] = Normalized_Vector;
+
+			glm::dvec3 origin = t.a.ToDVec3();
+			if( apex == ExtrusionApex::Centroid )
+				origin = ( t.a.ToDVec3() + t.b.ToDVec3() + t.c.ToDVec3() ) / 3.0;
+
+			glm::dvec3 top_point = origin + glm::dvec3( Normalized_Vector ) * ( double ) extrusionHeight;
+			CoordinateT<T> top( T( top_point.x ), T( top_point.y ), T( top_point.z ) );
+
+			size_t side = count + i * 3;
+			triangles[ side ] = TriangleT<T>( top, t.b, t.a, t.type - 1 );
+			triangles[ side + 1 ] = TriangleT<T>( top, t.a, t.c, t.type - 1 );
+			triangles[ side + 2 ] = TriangleT<T>( top, t.c, t.b, t.type - 1 );
+
+			for( size_t j = side; j < side + 3; j++ )
+				normals[ j ] = triangles[ j ].GetNormalOfTriangle();
 		}
-	}
+	} );
 
-	return vertices;
+	NumTriangles = triangles.size();
 }
 
-float *Penrose::GetVerticesWithColors(){
-	int vectorSize = NumTriangles * 18;
-	float *vertices = new float[ vectorSize ];
+namespace{
 
-	int i = 0;
-	for( Triangle t : triangles ){
-		float *triangleVertices = t.getTriangleCoordinatesWithColors();
-
-		for( int j = 0; j < 18; j++ ){
-			vertices[ i ] = triangleVertices[ j ];
-			i++;
+template<typename T>
+void RotateTriangles( TriangleList<T> &triangles, const Rotation3D &rotation, unsigned int threads ){
+	ParallelFor( triangles.size(), threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		for( size_t i = begin; i < end; i++ ){
+			TriangleT<T> &t = triangles[ i ];
+			t.a = rotation.Apply( t.a );
+			t.b = rotation.Apply( t.b );
+			t.c = rotation.Apply( t.c );
 		}
+	} );
+}
 
-	}
-
-	return vertices;
+// Float triangles are three packed float points followed by the type, so the SIMD kernel can walk them in place
+template<>
+void RotateTriangles<float>( TriangleList<float> &triangles, const Rotation3D &rotation, unsigned int threads ){
+	static_assert( sizeof( TriangleT<float> ) % sizeof( float ) == 0, "Triangle must be a whole number of floats" );
+	const size_t stride = sizeof( TriangleT<float> ) / sizeof( float );
+
+	ParallelFor( triangles.size(), threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		if( begin == end )
+			return;
+
+		float *first = &triangles[ begin ].a.x;
+		rotation.Apply( first, end - begin, stride );
+		rotation.Apply( first + 3, end - begin, stride );
+		rotation.Apply( first + 6, end - begin, stride );
+	} );
 }
 
-float *Penrose::GetVerticesWithTextureCoords(){
-	int vectorSize = NumTriangles * 18;
-	float *vertices = new float[ vectorSize ];
+}
 
-	int i = 0;
-	for( Triangle t : triangles ){
-		float *triangleVertices = t.getTriangleCoordinatesWithTexCoords();
+/**
+ * Rotate every triangle of the tilling
+ *
+ * @param rotation: Rotation built once for the whole tilling
+ * @param threads: Number of workers, 0 for one per hardware thread
+ */
+template<typename T>
+void PenroseT<T>::Rotate( const Rotation3D &rotation, unsigned int threads ){
+	PROFILE_SCOPE( "Penrose::Rotate" );
+	RotateTriangles( triangles, rotation, threads );
+
+	// Normals are directions, only the matrix applies to them
+	ParallelFor( normals.size(), threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		for( size_t i = begin; i < end; i++ )
+			normals[ i ] = glm::vec3( rotation.GetMatrix() * glm::dvec3( normals[ i ] ) );
+	} );
+}
 
-		for( int j = 0; j < 18; j++ ){
-			vertices[ i ] = triangleVertices[ j ];
-			i++;
-		}
+template<typename T>
+size_t PenroseT<T>::WriteVertices( VertexFormat format, Span<float> out, unsigned int threads ) const{
+	return VisitVertexFormat( format, [ & ]( auto tag ){
+		return WriteVertices<typename decltype( tag )::type>( out, threads );
+	} );
+}
 
-	}
+// @return an array of floats from the arena, or from new[] without one
+template<typename T>
+float *PenroseT<T>::AllocateVertices( size_t floats ){
+	return arena ? arena->AllocateArray<float>( floats ) : new float[ floats ];
+}
 
+template<typename T>
+float *PenroseT<T>::SerialiseVertices( VertexFormat format ){
+	size_t floats = GetVertexFloats( format );
+	float *vertices = AllocateVertices( floats );
+	WriteVertices( format, Span<float>( vertices, floats ) );
 	return vertices;
 }
 
-float *Penrose::GetVerticesWithColorsAndTextureCoords(){
-	int vectorSize = NumTriangles * 27;
-	float *vertices = new float[ vectorSize ];
-
-	int i = 0;
-	for( Triangle t : triangles ){
-		float *triangleVertices = t.getTriangleCoordinatesWithColorsAndTexCoords();
-
-		for( int j = 0; j < 27; j++ ){
-			vertices[ i ] = triangleVertices[ j ];
-			i++;
-		}
-
-	}
+template<typename T>
+float *PenroseT<T>::GetVertices(){
+	PROFILE_SCOPE( "Penrose::GetVertices" );
+	return SerialiseVertices( VertexFormat::Position );
+}
 
-	return vertices;
+template<typename T>
+float *PenroseT<T>::GetVerticesWithColors(){
+	PROFILE_SCOPE( "Penrose::GetVerticesWithColors" );
+	return SerialiseVertices( VertexFormat::PositionColor );
 }
 
-float *Penrose::GetVerticesWithColorsTexCoordsAndNormalLight(){
-	int vectorSize = NumTriangles * 36;
-	float *vertices = new float[ vectorSize ];
+template<typename T>
+float *PenroseT<T>::GetVerticesWithTextureCoords(){
+	PROFILE_SCOPE( "Penrose::GetVerticesWithTextureCoords" );
+	return SerialiseVertices( VertexFormat::PositionTexCoord );
+}
 
-	int i = 0;
-	for( Triangle t : triangles ){
-		float *triangleVertices = t.getTriangleCoordinatesWithColorsTexCoordsAndNormalLight();
+template<typename T>
+float *PenroseT<T>::GetVerticesWithColorsAndTextureCoords(){
+	PROFILE_SCOPE( "Penrose::GetVerticesWithColorsAndTextureCoords" );
+	return SerialiseVertices( VertexFormat::PositionColorTexCoord );
+}
 
-		for( int j = 0; j < 36; j++ ){
-			vertices[ i ] = triangleVertices[ j ];
-			i++;
-		}
+template<typename T>
+float *PenroseT<T>::GetVerticesWithColorsTexCoordsAndNormalLight(){
+	PROFILE_SCOPE( "Penrose::GetVerticesWithColorsTexCoordsAndNormalLight" );
+	return SerialiseVertices( VertexFormat::PositionColorTexCoordNormal );
+}
 
-	}
+template<typename T>
+size_t PenroseT<T>::GetNumTilesOfType( int type ) const{
+	size_t count = 0;
+	for( const TriangleT<T> &t : triangles )
+		count += t.type == type;
+	return count;
+}
 
-	return vertices;
+template<typename T>
+size_t PenroseT<T>::WriteInstances( int type, Span<TileInstance> out ) const{
+	PROFILE_SCOPE( "Penrose::WriteInstances" );
+	size_t count = 0;
+	for( size_t i = 0; i < triangles.size() && count < out.size(); i++ )
+		if( triangles[ i ].type == type )
+			out[ count++ ] = triangles[ i ].GetInstance();
+	return count;
 }
+
+// Scalars the tilling can be generated with, see FixedPoint.h for Fixed32
+template class PenroseT<float>;
+template class PenroseT<double>;
+template class PenroseT<Fixed32>;
\ No newline at end of file
@@ -4,117 +4,133 @@
 #include <math.h>
 #define PHI (1 + sqrt(5)) / 2
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
+#include <utility>
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-struct Coordinate{
-	float x;
-	float y;
-	float z;
-
-	Coordinate(){
-		x = 0.0f;
-		y = 0.0f;
-		z = 0.0f;
+#include "Arena.h"
+#include "FixedPoint.h"
+#include "Parallel.h"
+#include "Profiler.h"
+#include "Rotation3D.h"
+#include "Span.h"
+#include "VertexFormats.h"
+
+// Point in space, T is the scalar used to store and generate the tilling ( float, double or Fixed32 )
+template<typename T>
+struct CoordinateT{
+	T x;
+	T y;
+	T z;
+
+	CoordinateT(){
+		x = T( 0.0 );
+		y = T( 0.0 );
+		z = T( 0.0 );
 	}
 
-	Coordinate(float _x, float _y){
+	CoordinateT( T _x, T _y ){
 		x = _x;
 		y = _y;
-		z = 0.0f;
+		z = T( 0.0 );
 	}
 
-	Coordinate( float _x, float _y, float _z){
+	CoordinateT( T _x, T _y, T _z ){
 		x = _x;
 		y = _y;
 		z = _z;
 	}
 
+	// @return the coordinate as float, used only when the vertices are emitted
+	glm::vec3 ToVec3() const{
+		return glm::vec3( static_cast< float >( x ), static_cast< float >( y ), static_cast< float >( z ) );
+	}
+
+	glm::dvec3 ToDVec3() const{
+		return glm::dvec3( static_cast< double >( x ), static_cast< double >( y ), static_cast< double >( z ) );
+	}
+
 	// @return the vectorial sum of two coordinates
-	static Coordinate sum( Coordinate a, Coordinate b ){
-		return Coordinate( a.x + b.x, a.y + b.y, a.z + b.z );
+	static CoordinateT sum( CoordinateT a, CoordinateT b ){
+		return CoordinateT( a.x + b.x, a.y + b.y, a.z + b.z );
 	}
 
 	// @return the vectorial difference of two coordinates
-	static Coordinate diff( Coordinate a, Coordinate b ){
-		return Coordinate( a.x - b.x, a.y - b.y, a.z - b.z );
+	static CoordinateT diff( CoordinateT a, CoordinateT b ){
+		return CoordinateT( a.x - b.x, a.y - b.y, a.z - b.z );
 	}
 
 	// @return the divition of both values in coordinate by b
-	static Coordinate divide( Coordinate a, float b ){
-		return Coordinate( a.x / b, a.y / b, a.z / b);
+	static CoordinateT divide( CoordinateT a, double b ){
+		T divisor = T( b );
+		return CoordinateT( a.x / divisor, a.y / divisor, a.z / divisor );
 	}
 
 	// @return the rotation point p around some origin point
-	static Coordinate RotatePoint( Coordinate origin, float angle, Coordinate p ){
-		float rad = angle * M_PI / 180;
-		float px = p.x;
-		float py = p.y;
-
-		float s = sin( rad );
-		float c = cos( rad );
-
-		// translate point back to origin:
-		px -= origin.x;
-		py -= origin.y;
-
-		// rotate point
-		float xnew = px * c - py * s;
-		float ynew = px * s + py * c;
-
-		// translate point back:
-		px = xnew + origin.x;
-		py = ynew + origin.y;
-		return Coordinate( px, py, 0 );
+	static CoordinateT RotatePoint( CoordinateT origin, float angle, CoordinateT p ){
+		CoordinateT rotated = Rotation3D( Axis::Z, angle, origin.ToDVec3() ).Apply( p );
+		rotated.z = T( 0.0 );
+		return rotated;
 	}
 
-	// @return the rotation point p around some origin point r3 we can select the axis (X, Y, Z, XY, XZ, YZ)
-	static Coordinate RotatePoint3D( Coordinate origin, float angle, Coordinate p, std::string axis ){
-		float rad = angle * M_PI / 180;
-		glm::vec4 rotated_point = glm::vec4( 0.0f, 0.0f, 0.0f, 0.0f );
-		glm::vec4 point_to_rotate = glm::vec4( p.x - origin.x, p.y - origin.y, p.z - origin.z, 0.0f );
-		glm::vec3 axis_to_rotate;
-
-
-		if( axis == "X" ){
-			axis_to_rotate = glm::vec3( 1, 0, 0 );
-		} else if( axis == "Y" ){
-			axis_to_rotate = glm::vec3( 0, 1, 0 );
-		} else if( axis == "Z" ){
-			axis_to_rotate = glm::vec3( 0, 0, 1 );
-		} else if( axis == "XY" ){
-			axis_to_rotate = glm::vec3( 1, 1, 0 );
-		} else if( axis == "XZ" ){
-			axis_to_rotate = glm::vec3( 1, 0, 1 );
-		} else{
-			axis_to_rotate = glm::vec3( 0, 1, 1 );
-		}
-
-		glm::mat4 identity = glm::mat4( 1.0f );
-
-		rotated_point = point_to_rotate * glm::rotate( identity, rad, axis_to_rotate );
+	/**
+	 * @return the point p - origin rotated by -angle around the axis, the origin is not added back.
+	 * To rotate many points build a Rotation3D once and use Rotation3D::Apply instead
+	 */
+	static CoordinateT RotatePoint3D( CoordinateT origin, float angle, CoordinateT p, Axis axis ){
+		return Rotation3D( axis, -angle ).Apply( CoordinateT::diff( p, origin ) );
+	}
 
-		return Coordinate( rotated_point.x, rotated_point.y, rotated_point.z );
+	// @return the rotation point p around some origin point r3 we can select the axis (X, Y, Z, XY, XZ, YZ)
+	static CoordinateT RotatePoint3D( CoordinateT origin, float angle, CoordinateT p, std::string axis ){
+		return RotatePoint3D( origin, angle, p, AxisFromName( axis ) );
 	}
 
 	// @return distance between to coordinates
-	static float dist( Coordinate a, Coordinate b ){
-		return sqrt( pow( ( a.x - b.x ), 2 ) + pow( ( a.y - b.y ), 2 ) + pow( ( a.z - b.z ), 2 ) );
+	static double dist( CoordinateT a, CoordinateT b ){
+		double dx = static_cast< double >( a.x - b.x );
+		double dy = static_cast< double >( a.y - b.y );
+		double dz = static_cast< double >( a.z - b.z );
+		return sqrt( dx * dx + dy * dy + dz * dz );
 	}
 };
 
-struct Triangle{
-	Coordinate a;
-	Coordinate b;
-	Coordinate c;
+/**
+ * Placement of a tile on the prototype of its type ( TriangleT::Prototype ): every tile of a type is
+ * the same triangle rotated, scaled and maybe mirrored, so 4 floats stand for its 3 vertices
+ */
+struct TileInstance{
+	// Corner a
+	float x;
+	float y;
+	// Angle of the side ab in radians
+	float rotation;
+	// Length of the side ab, negative for the tiles that are the mirror image of the prototype
+	float scale;
+};
+
+template<typename T>
+struct TriangleT{
+	// Texture coords of the corners a, b and c
+	static constexpr float TEX_COORDS[ 3 ][ 2 ] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.5f, 1.0f } };
+
+	CoordinateT<T> a;
+	CoordinateT<T> b;
+	CoordinateT<T> c;
 	//  0 for 36 iso triangle, 1 for 108 degree iso triangle
 	int type;
 
+	TriangleT(){
+		type = 0;
+	}
+
 	// Default type = 0
-	Triangle( Coordinate pointA, Coordinate pointB, Coordinate pointC ){
+	TriangleT( CoordinateT<T> pointA, CoordinateT<T> pointB, CoordinateT<T> pointC ){
 		a = pointA;
 		b = pointB;
 		c = pointC;
@@ -122,512 +138,262 @@ struct Triangle{
 	}
 
 	// Default t = type, 0 for green triangles, 1 for blue triangles
-	Triangle( Coordinate pointA, Coordinate pointB, Coordinate pointC, int t ){
+	TriangleT( CoordinateT<T> pointA, CoordinateT<T> pointB, CoordinateT<T> pointC, int t ){
 		a = pointA;
 		b = pointB;
 		c = pointC;
 		type = t + 1;
 	}
 
-	glm::vec3 GetNormalOfTriangle(){
-		glm::vec3 u = glm::vec3( b.x - a.x, b.y - a.y, b.z - a.z );
-		glm::vec3 v = glm::vec3( c.x - a.x, c.y - a.y, c.z - a.z );
-
-		glm::vec3 Normal_Vector = glm::cross( u, v );
-		glm::vec3 Normalized_Vector = glm::normalize( Normal_Vector );
-
-		return Normalized_Vector;
+	/**
+	 * @return the tile of the type with the apex a at the origin, b at ( 1, 0 ) and c above the x axis,
+	 * 36 degrees at the apex for type 1 and 108 for type 2
+	 */
+	static TriangleT Prototype( int type ){
+		const double apex = ( type == 2 ? 3.0 : 1.0 ) * glm::pi<double>() / 5.0;
+		return TriangleT( CoordinateT<T>( T( 0.0 ), T( 0.0 ) ), CoordinateT<T>( T( 1.0 ), T( 0.0 ) ),
+			CoordinateT<T>( T( cos( apex ) ), T( sin( apex ) ) ), type - 1 );
 	}
 
-	float *getTriangleCoordinates(){
-		float coordinates[] = {
-			a.x, a.y, a.z,
-			b.x, b.y, b.z,
-			c.x, c.y, c.z,
-		};
-
-		return coordinates;
+	// @return where the triangle is on its Prototype, for the tiles of the flat tilling ( z = 0 )
+	TileInstance GetInstance() const{
+		glm::dvec3 origin = a.ToDVec3();
+		glm::dvec3 u = b.ToDVec3() - origin;
+		glm::dvec3 v = c.ToDVec3() - origin;
+		double scale = sqrt( u.x * u.x + u.y * u.y );
+		// c on the right of ab is the mirror image of the prototype
+		bool mirrored = u.x * v.y - u.y * v.x < 0.0;
+		return { ( float ) origin.x, ( float ) origin.y, ( float ) atan2( u.y, u.x ), ( float ) ( mirrored ? -scale : scale ) };
 	}
 
-	// Depends of type 1 for blue, 0 for red
-	float *getTriangleCoordinatesWithColors(){
-		float coordinates[ 18 ];
-
-		if( type ){
-
-			// Position
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.204;
-			coordinates[ 4 ] = 0.275;
-			coordinates[ 5 ] = 0.722;
-
-			// Position
-			coordinates[ 6 ] = b.x;
-			coordinates[ 7 ] = b.y;
-			coordinates[ 8 ] = b.z;
-			// Color
-			coordinates[ 9 ] = 0.204;
-			coordinates[ 10 ] = 0.275;
-			coordinates[ 11 ] = 0.722;
-
-			// Position
-			coordinates[ 12 ] = c.x;
-			coordinates[ 13 ] = c.y;
-			coordinates[ 14 ] = c.z;
-			// Color
-			coordinates[ 15 ] = 0.204;
-			coordinates[ 16 ] = 0.275;
-			coordinates[ 17 ] = 0.722;
+	glm::vec3 GetNormalOfTriangle() const{
+		glm::dvec3 pointA = glm::dvec3( static_cast< double >( a.x ), static_cast< double >( a.y ), static_cast< double >( a.z ) );
+		glm::dvec3 u = glm::dvec3( static_cast< double >( b.x ), static_cast< double >( b.y ), static_cast< double >( b.z ) ) - pointA;
+		glm::dvec3 v = glm::dvec3( static_cast< double >( c.x ), static_cast< double >( c.y ), static_cast< double >( c.z ) ) - pointA;
 
-		} else{
+		glm::dvec3 Normal_Vector = glm::cross( u, v );
+		glm::dvec3 Normalized_Vector = glm::normalize( Normal_Vector );
 
-			// Position
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.804;
-			coordinates[ 4 ] = 0.141;
-			coordinates[ 5 ] = 0.557;
-
-			// Position
-			coordinates[ 6 ] = b.x;
-			coordinates[ 7 ] = b.y;
-			coordinates[ 8 ] = b.z;
-			// Color
-			coordinates[ 9 ] = 0.804;
-			coordinates[ 10 ] = 0.141;
-			coordinates[ 11 ] = 0.557;
-
-			// Position
-			coordinates[ 12 ] = c.x;
-			coordinates[ 13 ] = c.y;
-			coordinates[ 14 ] = c.z;
-			// Color
-			coordinates[ 15 ] = 0.804;
-			coordinates[ 16 ] = 0.141;
-			coordinates[ 17 ] = 0.557;
-
-		}
-
-
-		return coordinates;
+		return glm::vec3( Normalized_Vector );
 	}
 
-	// @return the coordinates of vetices and texture coords
-	float *getTriangleCoordinatesWithTexCoords(){
-		float coordinates[ 18 ];
-
-		if( type ){
-
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			coordinates[ 3 ] = 0.0f;
-			coordinates[ 4 ] = 0.0f;
-			coordinates[ 5 ] = 0.0f;
-
-
-			coordinates[ 6 ] = b.x;
-			coordinates[ 7 ] = b.y;
-			coordinates[ 8 ] = b.z;
-			coordinates[ 9 ] = 1.0f;
-			coordinates[ 10 ] = 0.0f;
-			coordinates[ 11 ] = 0.0f;
-
-			coordinates[ 12 ] = c.x;
-			coordinates[ 13 ] = c.y;
-			coordinates[ 14 ] = c.z;
-			coordinates[ 15 ] = 0.5f;
-			coordinates[ 16 ] = 1.0f;
-			coordinates[ 17 ] = 0.0f;
-
-		} else{
-
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			coordinates[ 3 ] = 0.0f;
-			coordinates[ 4 ] = 0.0f;
-			coordinates[ 5 ] = 1.0f;
-
-
-			coordinates[ 6 ] = b.x;
-			coordinates[ 7 ] = b.y;
-			coordinates[ 8 ] = b.z;
-			coordinates[ 9 ] = 1.0f;
-			coordinates[ 10 ] = 0.0f;
-			coordinates[ 11 ] = 1.0f;
-
-			coordinates[ 12 ] = c.x;
-			coordinates[ 13 ] = c.y;
-			coordinates[ 14 ] = c.z;
-			coordinates[ 15 ] = 0.5f;
-			coordinates[ 16 ] = 1.0f;
-			coordinates[ 17 ] = 1.0f;
-
-		}
+	/**
+	 * Write the three vertices in Format through out, which can be a pointer into any memory or an
+	 * output iterator. The packing comes from the attributes of the format, see VertexFormats.h
+	 *
+	 * @return the iterator past the last float
+	 */
+	template<typename Format, typename OutputIt>
+	OutputIt Write( OutputIt out ) const{
+		// Folded away for the formats without normals
+		glm::vec3 normal = HasSemantic<Format>( VertexSemantic::Normal ) ? GetNormalOfTriangle() : glm::vec3( 0.0f );
+		return Write<Format>( out, normal );
+	}
 
+	// Same as above with a normal already known, like the ones stored by Penrose::DoIt3D
+	template<typename Format, typename OutputIt>
+	OutputIt Write( OutputIt out, glm::vec3 normal ) const{
+		static_assert( IsFloatFormat<Format>(), "TriangleT::Write only packs float attributes with the components of their semantic" );
 
+		const glm::vec3 corners[] = { a.ToVec3(), b.ToVec3(), c.ToVec3() };
+		for( int i = 0; i < 3; i++ )
+			out = WriteCorner<Format>( out, i, corners[ i ], normal, std::make_index_sequence<std::size( Format::ATTRIBUTES )>() );
+		return out;
+	}
 
-		return coordinates;
+	// Expands to one WriteAttribute per attribute, each one with its semantic known at compile time
+	template<typename Format, typename OutputIt, size_t... Attributes>
+	OutputIt WriteCorner( OutputIt out, int corner, const glm::vec3 &position, const glm::vec3 &normal, std::index_sequence<Attributes...> ) const{
+		( ( out = WriteAttribute<Format::ATTRIBUTES[ Attributes ].semantic>( out, corner, position, normal ) ), ... );
+		return out;
 	}
 
-	// @return the coordinates of vetices and texture coords
-	float *getTriangleCoordinatesWithColorsAndTexCoords(){
-		float coordinates[ 27 ];
-
-		if( type == 2 ){
-
-			// Coordenadas
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.7f;
-			coordinates[ 4 ] = 0.7f;
-			coordinates[ 5 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 6 ] = 0.0f;
-			coordinates[ 7 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 8 ] = 2.0f;
-
-			// Coordenadas
-			coordinates[ 9 ] = b.x;
-			coordinates[ 10 ] = b.y;
-			coordinates[ 11 ] = b.z;
-			// Color
-			coordinates[ 12 ] = 0.7f;
-			coordinates[ 13 ] = 0.7f;
-			coordinates[ 14 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 15 ] = 1.0f;
-			coordinates[ 16 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 17 ] = 2.0f;
-
-			// Coordenadas
-			coordinates[ 18 ] = c.x;
-			coordinates[ 19 ] = c.y;
-			coordinates[ 20 ] = c.z;
-			// Color
-			coordinates[ 21 ] = 0.7f;
-			coordinates[ 22 ] = 0.7f;
-			coordinates[ 23 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 24 ] = 0.5f;
-			coordinates[ 25 ] = 1.0f;
-			// Indice de Textura
-			coordinates[ 26 ] = 2.0f;
-
-		} else if( type == 1 ){
-
-			// Coordenadas
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.7f;
-			coordinates[ 4 ] = 0.7f;
-			coordinates[ 5 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 6 ] = 0.0f;
-			coordinates[ 7 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 8 ] = 1.0f;
-
-			// Coordenadas
-			coordinates[ 9 ] = b.x;
-			coordinates[ 10 ] = b.y;
-			coordinates[ 11 ] = b.z;
-			// Color
-			coordinates[ 12 ] = 0.7f;
-			coordinates[ 13 ] = 0.7f;
-			coordinates[ 14 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 15 ] = 1.0f;
-			coordinates[ 16 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 17 ] = 1.0f;
-
-			// Coordenadas
-			coordinates[ 18 ] = c.x;
-			coordinates[ 19 ] = c.y;
-			coordinates[ 20 ] = c.z;
-			// Color
-			coordinates[ 21 ] = 0.7f;
-			coordinates[ 22 ] = 0.7f;
-			coordinates[ 23 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 24 ] = 0.5f;
-			coordinates[ 25 ] = 1.0f;
-			// Indice de Textura
-			coordinates[ 26 ] = 1.0f;
+	// Floats of one attribute of the corner
+	template<VertexSemantic Semantic, typename OutputIt>
+	OutputIt WriteAttribute( OutputIt out, int corner, const glm::vec3 &position, const glm::vec3 &normal ) const{
+		const glm::vec4 value = AttributeValue<Semantic>( corner, position, normal );
+		for( unsigned int i = 0; i < SemanticComponents( Semantic ); i++ )
+			*out++ = value[ i ];
+		return out;
+	}
 
-		} else{
+	/**
+	 * Pack the three vertices in Format, any format of VertexFormats.h including the packed ones,
+	 * VertexStride<Format>() bytes per vertex with the padding zeroed
+	 *
+	 * @return the byte past the last vertex
+	 */
+	template<typename Format>
+	unsigned char *Pack( unsigned char *out ) const{
+		glm::vec3 normal = HasSemantic<Format>( VertexSemantic::Normal ) ? GetNormalOfTriangle() : glm::vec3( 0.0f );
+		return Pack<Format>( out, normal );
+	}
 
-			// Coordenadas
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.7f;
-			coordinates[ 4 ] = 0.7f;
-			coordinates[ 5 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 6 ] = 0.0f;
-			coordinates[ 7 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 8 ] = 0.0f;
-
-			// Coordenadas
-			coordinates[ 9 ] = b.x;
-			coordinates[ 10 ] = b.y;
-			coordinates[ 11 ] = b.z;
-			// Color
-			coordinates[ 12 ] = 0.7f;
-			coordinates[ 13 ] = 0.7f;
-			coordinates[ 14 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 15 ] = 1.0f;
-			coordinates[ 16 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 17 ] = 0.0f;
-
-			// Coordenadas
-			coordinates[ 18 ] = c.x;
-			coordinates[ 19 ] = c.y;
-			coordinates[ 20 ] = c.z;
-			// Color
-			coordinates[ 21 ] = 0.7f;
-			coordinates[ 22 ] = 0.7f;
-			coordinates[ 23 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 24 ] = 0.5f;
-			coordinates[ 25 ] = 1.0f;
-			// Indice de Textura
-			coordinates[ 26 ] = 0.0f;
+	template<typename Format>
+	unsigned char *Pack( unsigned char *out, glm::vec3 normal ) const{
+		static_assert( IsValidFormat<Format>(), "TriangleT::Pack: misaligned attribute or too few components for its semantic" );
+		constexpr unsigned int padding = VertexStride<Format>() - AttributeOffset<Format>( std::size( Format::ATTRIBUTES ) );
 
+		const glm::vec3 corners[] = { a.ToVec3(), b.ToVec3(), c.ToVec3() };
+		for( int i = 0; i < 3; i++ ){
+			out = PackCorner<Format>( out, i, corners[ i ], normal, std::make_index_sequence<std::size( Format::ATTRIBUTES )>() );
+			for( unsigned int j = 0; j < padding; j++ )
+				*out++ = 0;
 		}
-
-		return coordinates;
+		return out;
 	}
 
-	// @return the coordinates of vetices and texture coords and normals for light
-	float *getTriangleCoordinatesWithColorsTexCoordsAndNormalLight(){
-		float coordinates[ 36 ];
-
-		glm::vec3 normal = GetNormalOfTriangle();
-
-		if( type == 2 ){
-
-			// Coordenadas
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.7f;
-			coordinates[ 4 ] = 0.7f;
-			coordinates[ 5 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 6 ] = 0.0f;
-			coordinates[ 7 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 8 ] = 2.0f;
-			// Normal para la Luz
-			coordinates[ 9 ] = normal.x;
-			coordinates[ 10 ] = normal.y;
-			coordinates[ 11 ] = normal.z;
-
-			// Coordenadas
-			coordinates[ 12 ] = b.x;
-			coordinates[ 13 ] = b.y;
-			coordinates[ 14 ] = b.z;
-			// Color
-			coordinates[ 15 ] = 0.7f;
-			coordinates[ 16 ] = 0.7f;
-			coordinates[ 17 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 18 ] = 1.0f;
-			coordinates[ 19 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 20 ] = 2.0f;
-			// Normal para la Luz
-			coordinates[ 21 ] = normal.x;
-			coordinates[ 22 ] = normal.y;
-			coordinates[ 23 ] = normal.z;
-
-			// Coordenadas
-			coordinates[ 24 ] = c.x;
-			coordinates[ 25 ] = c.y;
-			coordinates[ 26 ] = c.z;
-			// Color
-			coordinates[ 27 ] = 0.7f;
-			coordinates[ 28 ] = 0.7f;
-			coordinates[ 29 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 30 ] = 0.5f;
-			coordinates[ 31 ] = 1.0f;
-			// Indice de Textura
-			coordinates[ 32 ] = 2.0f;
-			// Normal para la Luz
-			coordinates[ 33 ] = normal.x;
-			coordinates[ 34 ] = normal.y;
-			coordinates[ 35 ] = normal.z;
-
-		} else if( type == 1 ){
-
-			// Coordenadas
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.7f;
-			coordinates[ 4 ] = 0.7f;
-			coordinates[ 5 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 6 ] = 0.0f;
-			coordinates[ 7 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 8 ] = 1.0f;
-			// Normal para la Luz
-			coordinates[ 9 ] = normal.x;
-			coordinates[ 10 ] = normal.y;
-			coordinates[ 11 ] = normal.z;
-
-			// Coordenadas
-			coordinates[ 12 ] = b.x;
-			coordinates[ 13 ] = b.y;
-			coordinates[ 14 ] = b.z;
-			// Color
-			coordinates[ 15 ] = 0.7f;
-			coordinates[ 16 ] = 0.7f;
-			coordinates[ 17 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 18 ] = 1.0f;
-			coordinates[ 19 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 20 ] = 1.0f;
-			// Normal para la Luz
-			coordinates[ 21 ] = normal.x;
-			coordinates[ 22 ] = normal.y;
-			coordinates[ 23 ] = normal.z;
-
-			// Coordenadas
-			coordinates[ 24 ] = c.x;
-			coordinates[ 25 ] = c.y;
-			coordinates[ 26 ] = c.z;
-			// Color
-			coordinates[ 27 ] = 0.7f;
-			coordinates[ 28 ] = 0.7f;
-			coordinates[ 29 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 30 ] = 0.5f;
-			coordinates[ 31 ] = 1.0f;
-			// Indice de Textura
-			coordinates[ 32 ] = 1.0f;
-			// Normal para la Luz
-			coordinates[ 33 ] = normal.x;
-			coordinates[ 34 ] = normal.y;
-			coordinates[ 35 ] = normal.z;
+	template<typename Format, size_t... Attributes>
+	unsigned char *PackCorner( unsigned char *out, int corner, const glm::vec3 &position, const glm::vec3 &normal, std::index_sequence<Attributes...> ) const{
+		( ( out = EncodeAttribute<Format::ATTRIBUTES[ Attributes ].type, Format::ATTRIBUTES[ Attributes ].count, Format::ATTRIBUTES[ Attributes ].normalized>(
+			out, AttributeValue<Format::ATTRIBUTES[ Attributes ].semantic>( corner, position, normal ) ) ), ... );
+		return out;
+	}
 
+	// @return the components of the attribute for the corner, the unused ones are 0 except the alpha of the colors
+	template<VertexSemantic Semantic>
+	glm::vec4 AttributeValue( int corner, const glm::vec3 &position, const glm::vec3 &normal ) const{
+		if constexpr( Semantic == VertexSemantic::Position ){
+			return glm::vec4( position, 0.0f );
+		} else if constexpr( Semantic == VertexSemantic::TileColor ){
+			return type ? glm::vec4( 0.204f, 0.275f, 0.722f, 1.0f ) : glm::vec4( 0.804f, 0.141f, 0.557f, 1.0f );
+		} else if constexpr( Semantic == VertexSemantic::Color ){
+			return glm::vec4( 0.7f, 0.7f, 0.7f, 1.0f );
+		} else if constexpr( Semantic == VertexSemantic::TexCoord ){
+			return glm::vec4( TEX_COORDS[ corner ][ 0 ], TEX_COORDS[ corner ][ 1 ], 0.0f, 0.0f );
+		} else if constexpr( Semantic == VertexSemantic::TexCoordLayer ){
+			return glm::vec4( TEX_COORDS[ corner ][ 0 ], TEX_COORDS[ corner ][ 1 ], type ? 0.0f : 1.0f, 0.0f );
+		} else if constexpr( Semantic == VertexSemantic::TexIndex ){
+			return glm::vec4( GetTextureIndex(), 0.0f, 0.0f, 0.0f );
+		} else if constexpr( Semantic == VertexSemantic::Tile ){
+			return glm::vec4( ( float ) ( ( int ) GetTextureIndex() | corner << 2 ), 0.0f, 0.0f, 0.0f );
 		} else{
-
-			// Coordenadas
-			coordinates[ 0 ] = a.x;
-			coordinates[ 1 ] = a.y;
-			coordinates[ 2 ] = a.z;
-			// Color
-			coordinates[ 3 ] = 0.7f;
-			coordinates[ 4 ] = 0.7f;
-			coordinates[ 5 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 6 ] = 0.0f;
-			coordinates[ 7 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 8 ] = 0.0f;
-			// Normal para la Luz
-			coordinates[ 9 ] = normal.x;
-			coordinates[ 10 ] = normal.y;
-			coordinates[ 11 ] = normal.z;
-
-			// Coordenadas
-			coordinates[ 12 ] = b.x;
-			coordinates[ 13 ] = b.y;
-			coordinates[ 14 ] = b.z;
-			// Color
-			coordinates[ 15 ] = 0.7f;
-			coordinates[ 16 ] = 0.7f;
-			coordinates[ 17 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 18 ] = 1.0f;
-			coordinates[ 19 ] = 0.0f;
-			// Indice de Textura
-			coordinates[ 20 ] = 0.0f;
-			// Normal para la Luz
-			coordinates[ 21 ] = normal.x;
-			coordinates[ 22 ] = normal.y;
-			coordinates[ 23 ] = normal.z;
-
-			// Coordenadas
-			coordinates[ 24 ] = c.x;
-			coordinates[ 25 ] = c.y;
-			coordinates[ 26 ] = c.z;
-			// Color
-			coordinates[ 27 ] = 0.7f;
-			coordinates[ 28 ] = 0.7f;
-			coordinates[ 29 ] = 0.7f;
-			// Coordenadas de Textura
-			coordinates[ 30 ] = 0.5f;
-			coordinates[ 31 ] = 1.0f;
-			// Indice de Textura
-			coordinates[ 32 ] = 0.0f;
-			// Normal para la Luz
-			coordinates[ 33 ] = normal.x;
-			coordinates[ 34 ] = normal.y;
-			coordinates[ 35 ] = normal.z;
-
+			return glm::vec4( normal, 0.0f );
 		}
+	}
 
-		return coordinates;
+	// @return the sampler of the triangle in project.shader, 0 for anything that isn't type 1 or 2
+	float GetTextureIndex() const{
+		return type == 2 ? 2.0f : type == 1 ? 1.0f : 0.0f;
 	}
 
 	// @return a new issoceles triangle from point a, angle at point and height h
-	static Triangle iso( Coordinate a, int degree, float h ){
-		float rad = degree * M_PI / 180;
-		float dx = tan( rad / 2 ) * h;
-		Coordinate b( a.x - dx, a.y + h );
-		Coordinate c( a.x + dx, a.y + h );
+	static TriangleT iso( CoordinateT<T> a, int degree, double h ){
+		double rad = degree * M_PI / 180;
+		double dx = tan( rad / 2 ) * h;
+		CoordinateT<T> b( a.x - T( dx ), a.y + T( h ) );
+		CoordinateT<T> c( a.x + T( dx ), a.y + T( h ) );
 
 		if( degree == 36 ){
-			return Triangle( a, b, c, 0 );
+			return TriangleT( a, b, c, 0 );
 		} else if( degree == 108 ){
-			return Triangle( a, b, c, 1 );
+			return TriangleT( a, b, c, 1 );
 		} else{
-			return Triangle( a, b, c );
+			return TriangleT( a, b, c );
 		}
 
 	}
 };
 
-class Penrose{
+// Where the apex of the pyramid built over each triangle by DoIt3D starts from
+enum class ExtrusionApex{
+	VertexA,	// Over the first vertex of the triangle
+	Centroid	// Over the center of the triangle
+};
+
+// Triangles of a tilling, in the arena of the tilling when it has one
+template<typename T>
+using TriangleList = std::vector<TriangleT<T>, ArenaAllocator<TriangleT<T>>>;
+
+typedef std::vector<glm::vec3, ArenaAllocator<glm::vec3>> NormalList;
+
+template<typename T>
+class PenroseT{
 private:
 	int loops;
-	std::vector<Triangle> triangles;
+	int degree;
+	float height;
+	// Owner of every buffer of the tilling, null to use the heap
+	Arena *arena;
+	TriangleList<T> triangles;
+	// One per triangle after DoIt3D, empty otherwise
+	NormalList normals;
 	int NumTriangles;
 
+	float *AllocateVertices( size_t floats );
+	float *SerialiseVertices( VertexFormat format );
+
+	// Writes the triangles [begin, end)
+	template<typename Format, typename OutputIt>
+	OutputIt WriteTriangles( size_t begin, size_t end, OutputIt out ) const;
+	template<typename Format>
+	unsigned char *PackTriangles( size_t begin, size_t end, unsigned char *out ) const;
+
 public:
-	Penrose( int _loops, Coordinate _origin, int _degree, float _height );
-	~Penrose();
+	/**
+	 * With an arena the triangles, the normals and the arrays of GetVertices* are taken from it and
+	 * stay valid until it's Reset, without one they come from the heap and the arrays must be delete[]d
+	 */
+	PenroseT( int _loops, CoordinateT<T> _origin, int _degree, float _height, Arena *_arena = nullptr );
+	// A tilling grown from a single tile, like the prototypes of the instanced draw
+	explicit PenroseT( const TriangleT<T> &tile, int _loops = 0, Arena *_arena = nullptr );
+	~PenroseT();
 
 	void execute();
-	std::vector<Triangle> deflate();
-	void DoIt3D();
-	std::vector<Triangle> DoIT3D();
+	TriangleList<T> deflate();
+	void DoIt3D( float extrusionHeight = 1.0f, ExtrusionApex apex = ExtrusionApex::VertexA, unsigned int threads = 0 );
+	void Rotate( const Rotation3D &rotation, unsigned int threads = 0 );
+
+	// @return the floats WriteVertices writes for the whole tilling
+	inline size_t GetVertexFloats( VertexFormat format ) const{ return triangles.size() * 3 * FloatsPerVertex( format ); }
+
+	template<typename Format>
+	inline size_t GetVertexFloats() const{ return triangles.size() * 3 * VertexStride<Format>() / sizeof( float ); }
+
+	/**
+	 * Serialise the tilling straight into memory of the caller: an array, a mapped file or a mapped GL buffer.
+	 * The triangles are split in chunks and every worker writes its own range of out.
+	 *
+	 * @param out: GetVertexFloats<Format>() floats, only the triangles that fit whole are written
+	 * @param threads: Number of workers, 0 for one per hardware thread
+	 * @return the floats written
+	 */
+	template<typename Format>
+	size_t WriteVertices( Span<float> out, unsigned int threads = 0 ) const;
+
+	// Same with the format chosen at run time
+	size_t WriteVertices( VertexFormat format, Span<float> out, unsigned int threads = 0 ) const;
+
+	template<typename Format>
+	inline size_t GetVertexBytes() const{ return triangles.size() * 3 * VertexStride<Format>(); }
+
+	/**
+	 * Same as WriteVertices for any format, packed ones included, straight into GetVertexBytes<Format>() bytes
+	 *
+	 * @return the bytes written
+	 */
+	template<typename Format>
+	size_t PackVertices( Span<unsigned char> out, unsigned int threads = 0 ) const;
+
+	// Same on one thread through any output iterator of floats. @return the iterator past the last float
+	template<typename Format, typename OutputIt>
+	OutputIt WriteVerticesTo( OutputIt out ) const{
+		return WriteTriangles<Format>( 0, triangles.size(), out );
+	}
+
+	// @return the tiles of the type, 1 or 2, what WriteInstances writes for it
+	size_t GetNumTilesOfType( int type ) const;
+
+	/**
+	 * Write the TileInstance of every tile of the type, in order. Only for the flat tilling: after DoIt3D
+	 * or Rotate the tiles aren't on the z = 0 plane and the side faces would be taken as tiles.
+	 *
+	 * @param out: GetNumTilesOfType( type ) instances
+	 * @return the instances written
+	 */
+	size_t WriteInstances( int type, Span<TileInstance> out ) const;
+
+	// Arrays with WriteVertices in the matching format, see the constructor for who owns them
 	float *GetVertices();
 	float *GetVerticesWithColors();
 	float *GetVerticesWithTextureCoords();
@@ -635,4 +401,76 @@ public:
 	float *GetVerticesWithColorsTexCoordsAndNormalLight();
 
 	inline const int GetNumTriangles() const{ return NumTriangles; }
-};
\ No newline at end of file
+	inline int GetLoops() const{ return loops; }
+	inline int GetDegree() const{ return degree; }
+	inline float GetHeight() const{ return height; }
+	inline Arena *GetArena() const{ return arena; }
+	inline const TriangleList<T> &GetTriangles() const{ return triangles; }
+	inline const NormalList &GetNormals() const{ return normals; }
+};
+
+template<typename T>
+template<typename Format, typename OutputIt>
+OutputIt PenroseT<T>::WriteTriangles( size_t begin, size_t end, OutputIt out ) const{
+	if( HasSemantic<Format>( VertexSemantic::Normal ) && normals.size() == triangles.size() ){
+		for( size_t i = begin; i < end; i++ )
+			out = triangles[ i ].template Write<Format>( out, normals[ i ] );
+	} else{
+		for( size_t i = begin; i < end; i++ )
+			out = triangles[ i ].template Write<Format>( out );
+	}
+	return out;
+}
+
+template<typename T>
+template<typename Format>
+unsigned char *PenroseT<T>::PackTriangles( size_t begin, size_t end, unsigned char *out ) const{
+	if( HasSemantic<Format>( VertexSemantic::Normal ) && normals.size() == triangles.size() ){
+		for( size_t i = begin; i < end; i++ )
+			out = triangles[ i ].template Pack<Format>( out, normals[ i ] );
+	} else{
+		for( size_t i = begin; i < end; i++ )
+			out = triangles[ i ].template Pack<Format>( out );
+	}
+	return out;
+}
+
+template<typename T>
+template<typename Format>
+size_t PenroseT<T>::PackVertices( Span<unsigned char> out, unsigned int threads ) const{
+	PROFILE_SCOPE( "Penrose::PackVertices" );
+	const size_t triangleBytes = 3 * VertexStride<Format>();
+	const size_t count = std::min( triangles.size(), out.size() / triangleBytes );
+
+	if( count < 4096 )
+		threads = 1;
+
+	ParallelFor( count, threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		PackTriangles<Format>( begin, end, out.data() + begin * triangleBytes );
+	} );
+
+	return count * triangleBytes;
+}
+
+template<typename T>
+template<typename Format>
+size_t PenroseT<T>::WriteVertices( Span<float> out, unsigned int threads ) const{
+	PROFILE_SCOPE( "Penrose::WriteVertices" );
+	const size_t triangleFloats = 3 * VertexStride<Format>() / sizeof( float );
+	const size_t count = std::min( triangles.size(), out.size() / triangleFloats );
+
+	// Small tillings are done before a thread would start
+	if( count < 4096 )
+		threads = 1;
+
+	ParallelFor( count, threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		WriteTriangles<Format>( begin, end, out.data() + begin * triangleFloats );
+	} );
+
+	return count * triangleFloats;
+}
+
+// The float instantiation is the one used by the renderer
+typedef CoordinateT<float> Coordinate;
+typedef TriangleT<float> Triangle;
+typedef PenroseT<float> Penrose;
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "PenroseStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "Parallel.h"
+
+BigUInt::BigUInt( uint64_t value ){
+	while( value ){
+		m_Limbs.push_back( ( uint32_t ) value );
+		value >>= 32;
+	}
+}
+
+BigUInt &BigUInt::operator+=( const BigUInt &other ){
+	if( m_Limbs.size() < other.m_Limbs.size() )
+		m_Limbs.resize( other.m_Limbs.size(), 0 );
+
+	uint64_t carry = 0;
+	for( size_t i = 0; i < m_Limbs.size(); i++ ){
+		uint64_t sum = ( uint64_t ) m_Limbs[ i ] + carry;
+		if( i < other.m_Limbs.size() )
+			sum += other.m_Limbs[ i ];
+
+		m_Limbs[ i ] = ( uint32_t ) sum;
+		carry = sum >> 32;
+	}
+
+	if( carry )
+		m_Limbs.push_back( ( uint32_t ) carry );
+
+	return *this;
+}
+
+uint64_t BigUInt::ToUInt64() const{
+	uint64_t value = 0;
+	for( size_t i = 0; i < m_Limbs.size() && i < 2; i++ )
+		value |= ( uint64_t ) m_Limbs[ i ] << ( 32 * i );
+
+	return value;
+}
+
+long double BigUInt::ToLongDouble() const{
+	long double value = 0.0L;
+	for( size_t i = m_Limbs.size(); i > 0; i-- )
+		value = value * 4294967296.0L + m_Limbs[ i - 1 ];
+
+	return value;
+}
+
+std::string BigUInt::ToString() const{
+	if( IsZero() )
+		return "0";
+
+	// Repeated division by 10^9, collecting 9 decimal digits each time
+	std::vector<uint32_t> limbs = m_Limbs;
+	std::vector<uint32_t> groups;
+	while( !limbs.empty() ){
+		uint64_t remainder = 0;
+		for( size_t i = limbs.size(); i > 0; i-- ){
+			uint64_t current = ( remainder << 32 ) | limbs[ i - 1 ];
+			limbs[ i - 1 ] = ( uint32_t ) ( current / 1000000000 );
+			remainder = current % 1000000000;
+		}
+		groups.push_back( ( uint32_t ) remainder );
+
+		while( !limbs.empty() && limbs.back() == 0 )
+			limbs.pop_back();
+	}
+
+	std::string result = std::to_string( groups.back() );
+	for( size_t i = groups.size() - 1; i > 0; i-- ){
+		std::string group = std::to_string( groups[ i - 1 ] );
+		result += std::string( 9 - group.size(), '0' ) + group;
+	}
+
+	return result;
+}
+
+std::vector<LevelStats> PenroseStats::Analytic( int levels, const BigUInt &thin, const BigUInt &thick, double height ){
+	std::vector<LevelStats> result;
+	result.reserve( levels + 1 );
+
+	const long double phi = ( 1.0L + sqrtl( 5.0L ) ) / 2.0L;
+	const long double thinUnit = 0.5L * sinl( 36.0L * M_PI / 180.0L );
+	const long double thickUnit = 0.5L * sinl( 108.0L * M_PI / 180.0L );
+
+	BigUInt currentThin = thin;
+	BigUInt currentThick = thick;
+	// Equal sides of both triangle types shrink by PHI on every deflate
+	long double side = height;
+
+	for( int level = 0; level <= levels; level++ ){
+		LevelStats stats;
+		stats.level = level;
+		stats.thinTriangles = currentThin;
+		stats.thickTriangles = currentThick;
+		stats.totalTriangles = currentThin + currentThick;
+
+		long double thinCount = currentThin.ToLongDouble();
+		long double thickCount = currentThick.ToLongDouble();
+		stats.thinArea = thinCount * thinUnit * side * side;
+		stats.thickArea = thickCount * thickUnit * side * side;
+		stats.totalArea = stats.thinArea + stats.thickArea;
+		stats.thickThinRatio = thinCount > 0 ? thickCount / thinCount : 0.0L;
+		result.push_back( stats );
+
+		// Same rules as Penrose::deflate
+		BigUInt nextThin = currentThin + currentThick;
+		BigUInt nextThick = nextThin + currentThick;
+		currentThin = nextThin;
+		currentThick = nextThick;
+		side /= phi;
+	}
+
+	return result;
+}
+
+/**
+ * The constructor of Penrose always seeds 360 / degree triangles of type 1,
+ * so level 0 is rebuilt from its parameters even after execute()
+ */
+std::vector<LevelStats> PenroseStats::Analytic( const Penrose &p ){
+	return Analytic( p.GetLoops(), BigUInt( 360 / p.GetDegree() ), BigUInt( 0 ), p.GetHeight() );
+}
+
+namespace{
+
+// Cells of a quantum grid are grouped in blocks of BLOCK_CELLS x BLOCK_CELLS, each block goes to one shard
+const int64_t BLOCK_CELLS = 64;
+
+// Copies of a vertex are merged when less than this part of a cell apart on each axis
+const double CELL_TOLERANCE = 0.25;
+
+struct Corner{
+	// Cell of the quantum grid the corner falls in
+	int64_t cx;
+	int64_t cy;
+	// Side of the cell the corner is within CELL_TOLERANCE of, -1, 1 or 0 when it's in the middle
+	signed char sx;
+	signed char sy;
+	char code;
+
+	Corner( double x, double y, double quantum, char _code )
+		: code( _code ){
+		double fx = std::floor( x / quantum );
+		double fy = std::floor( y / quantum );
+		cx = ( int64_t ) fx;
+		cy = ( int64_t ) fy;
+		sx = Side( x / quantum - fx );
+		sy = Side( y / quantum - fy );
+	}
+
+	static signed char Side( double fraction ){
+		return fraction < CELL_TOLERANCE ? -1 : ( fraction > 1.0 - CELL_TOLERANCE ? 1 : 0 );
+	}
+};
+
+// @return the corner codes of a triangle in order a, b, c ( see GeometricStats::vertexConfigurations )
+inline const char *CornerCodes( int type ){
+	return type == 2 ? "ABB" : "abb";
+}
+
+// @return the corner angle in units of 36 degrees
+inline int CornerUnits( char code ){
+	switch( code ){
+		case 'a':	return 1;
+		case 'b':	return 2;
+		case 'A':	return 3;
+		case 'B':	return 1;
+	}
+	return 0;
+}
+
+inline uint64_t CellKey( int64_t cx, int64_t cy ){
+	return ( ( uint64_t ) ( uint32_t ) cx << 32 ) | ( uint32_t ) cy;
+}
+
+inline int64_t FloorDiv( int64_t value, int64_t divisor ){
+	return value >= 0 ? value / divisor : -( ( -value + divisor - 1 ) / divisor );
+}
+
+inline unsigned int ShardOf( int64_t cx, int64_t cy, unsigned int shards ){
+	uint64_t block = CellKey( FloorDiv( cx, BLOCK_CELLS ), FloorDiv( cy, BLOCK_CELLS ) );
+	return ( unsigned int ) ( ( block * 0x9E3779B97F4A7C15ull ) >> 32 ) % shards;
+}
+
+// Whether the cells around the corner can belong to another block, and so to another shard
+inline bool OnSeam( const Corner &corner ){
+	int64_t x = corner.cx - FloorDiv( corner.cx, BLOCK_CELLS ) * BLOCK_CELLS;
+	int64_t y = corner.cy - FloorDiv( corner.cy, BLOCK_CELLS ) * BLOCK_CELLS;
+	return x == 0 || y == 0 || x == BLOCK_CELLS - 1 || y == BLOCK_CELLS - 1;
+}
+
+typedef std::unordered_map<uint64_t, std::string> VertexMap;
+
+/**
+ * Add the corner to the vertex already in its cell, or in a cell next to the sides it's close to, or else
+ * to a new vertex in its cell. At most 4 cells are looked at, 1 for most corners
+ *
+ * @param shards: Maps of every shard, only the ones of the cells around the corner are touched
+ */
+inline void AddCorner( std::vector<VertexMap> &shards, const Corner &corner ){
+	const unsigned int numShards = ( unsigned int ) shards.size();
+	// Its own cell, then the ones across the sides it's close to
+	const int64_t cells[ 4 ][ 2 ] = {
+		{ corner.cx, corner.cy },
+		{ corner.cx + corner.sx, corner.cy },
+		{ corner.cx, corner.cy + corner.sy },
+		{ corner.cx + corner.sx, corner.cy + corner.sy }
+	};
+	const bool candidates[ 4 ] = { true, corner.sx != 0, corner.sy != 0, corner.sx != 0 && corner.sy != 0 };
+
+	for( int i = 0; i < 4; i++ ){
+		if( !candidates[ i ] )
+			continue;
+		VertexMap &vertices = shards[ ShardOf( cells[ i ][ 0 ], cells[ i ][ 1 ], numShards ) ];
+		auto found = vertices.find( CellKey( cells[ i ][ 0 ], cells[ i ][ 1 ] ) );
+		if( found != vertices.end() ){
+			found->second += corner.code;
+			return;
+		}
+	}
+	shards[ ShardOf( corner.cx, corner.cy, numShards ) ][ CellKey( corner.cx, corner.cy ) ] += corner.code;
+}
+
+}
+
+template<typename T>
+GeometricStats PenroseStats::Measure( const TriangleList<T> &triangles, unsigned int threads ){
+	GeometricStats stats = {};
+	if( triangles.empty() )
+		return stats;
+
+	/*
+	 * The corners go in cells of a tenth of the shortest edge, and a corner joins a vertex already in its cell
+	 * or in a neighbouring one. Copies of a vertex less than CELL_TOLERANCE of a cell apart on each axis, a
+	 * fortieth of the shortest edge and far more than the float error, are always merged wherever the cell
+	 * boundaries fall. Different vertices are a whole edge apart and are never in neighbouring cells
+	 */
+	const TriangleT<T> &first = triangles.front();
+	double shortest = std::min( { CoordinateT<T>::dist( first.a, first.b ), CoordinateT<T>::dist( first.b, first.c ), CoordinateT<T>::dist( first.c, first.a ) } );
+	double quantum = shortest / 10.0;
+
+	unsigned int chunks = ParallelChunks( triangles.size(), threads );
+
+	struct ChunkResult{
+		GeometricStats stats = {};
+		// One list of corners per shard, so each shard can be merged by a single thread
+		std::vector<std::vector<Corner>> corners;
+		// Corners next to another block, merged after the shards
+		std::vector<Corner> seam;
+	};
+	std::vector<ChunkResult> partial( chunks );
+
+	ParallelFor( triangles.size(), chunks, [ & ]( size_t begin, size_t end, unsigned int chunk ){
+		ChunkResult &local = partial[ chunk ];
+		local.corners.resize( chunks );
+		for( std::vector<Corner> &shard : local.corners )
+			shard.reserve( 3 * ( end - begin ) / chunks + 16 );
+
+		for( size_t i = begin; i < end; i++ ){
+			const TriangleT<T> &t = triangles[ i ];
+
+			// In double, the areas of a double tilling keep its precision
+			glm::dvec3 u( t.b.x - t.a.x, t.b.y - t.a.y, t.b.z - t.a.z );
+			glm::dvec3 v( t.c.x - t.a.x, t.c.y - t.a.y, t.c.z - t.a.z );
+			double area = 0.5 * glm::length( glm::cross( u, v ) );
+
+			if( t.type == 2 ){
+				local.stats.thickTriangles++;
+				local.stats.thickArea += area;
+			} else{
+				local.stats.thinTriangles++;
+				local.stats.thinArea += area;
+			}
+
+			const char *codes = CornerCodes( t.type );
+			const CoordinateT<T> *points[ 3 ] = { &t.a, &t.b, &t.c };
+			for( int j = 0; j < 3; j++ ){
+				Corner corner( ( double ) points[ j ]->x, ( double ) points[ j ]->y, quantum, codes[ j ] );
+				if( OnSeam( corner ) )
+					local.seam.push_back( corner );
+				else
+					local.corners[ ShardOf( corner.cx, corner.cy, chunks ) ].push_back( corner );
+			}
+		}
+	} );
+
+	// Away from the seams every cell around a corner is in the shard of the corner
+	std::vector<VertexMap> shards( chunks );
+	ParallelFor( chunks, chunks, [ & ]( size_t begin, size_t end, unsigned int ){
+		for( size_t shard = begin; shard < end; shard++ ){
+			for( const ChunkResult &local : partial )
+				for( const Corner &corner : local.corners[ shard ] )
+					AddCorner( shards, corner );
+		}
+	} );
+
+	// About 4 / BLOCK_CELLS of the corners, the cells around them can be in several shards
+	for( const ChunkResult &local : partial )
+		for( const Corner &corner : local.seam )
+			AddCorner( shards, corner );
+
+	std::vector<GeometricStats> shardStats( chunks );
+
+	ParallelFor( chunks, chunks, [ & ]( size_t begin, size_t end, unsigned int ){
+		for( size_t shard = begin; shard < end; shard++ ){
+			GeometricStats &local = shardStats[ shard ];
+			for( auto &vertex : shards[ shard ] ){
+				std::string &configuration = vertex.second;
+
+				int units = 0;
+				for( char code : configuration )
+					units += CornerUnits( code );
+
+				if( units == 10 ){
+					std::sort( configuration.begin(), configuration.end() );
+					local.vertexConfigurations[ configuration ]++;
+					local.interiorVertices++;
+				} else{
+					local.boundaryVertices++;
+				}
+			}
+		}
+	} );
+
+	for( const ChunkResult &local : partial ){
+		stats.thinTriangles += local.stats.thinTriangles;
+		stats.thickTriangles += local.stats.thickTriangles;
+		stats.thinArea += local.stats.thinArea;
+		stats.thickArea += local.stats.thickArea;
+	}
+	stats.totalArea = stats.thinArea + stats.thickArea;
+
+	for( const GeometricStats &local : shardStats ){
+		stats.interiorVertices += local.interiorVertices;
+		stats.boundaryVertices += local.boundaryVertices;
+		for( const auto &configuration : local.vertexConfigurations )
+			stats.vertexConfigurations[ configuration.first ] += configuration.second;
+	}
+
+	return stats;
+}
+
+template GeometricStats PenroseStats::Measure( const TriangleList<float> &triangles, unsigned int threads );
+template GeometricStats PenroseStats::Measure( const TriangleList<double> &triangles, unsigned int threads );
+template GeometricStats PenroseStats::Measure( const TriangleList<Fixed32> &triangles, unsigned int threads );
+
+std::vector<GeometricStats> PenroseStats::MeasureLevels( int levels, Coordinate origin, int degree, float height, unsigned int threads ){
+	std::vector<GeometricStats> result;
+
+	// With one loop, every execute() deflates the current triangles once more
+	Penrose p( 1, origin, degree, height );
+	for( int level = 0; level <= levels; level++ ){
+		if( level > 0 )
+			p.execute();
+
+		result.push_back( Measure( p.GetTriangles(), threads ) );
+	}
+
+	return result;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Penrose.h"
+
+// Unsigned integer of arbitrary size, enough to count the triangles of a tilling hundreds of levels deep
+class BigUInt{
+private:
+	// Little endian base 2^32 limbs, no leading zero limbs
+	std::vector<uint32_t> m_Limbs;
+
+public:
+	BigUInt(){ }
+	BigUInt( uint64_t value );
+
+	BigUInt &operator+=( const BigUInt &other );
+	friend BigUInt operator+( BigUInt a, const BigUInt &b ){ return a += b; }
+	bool operator==( const BigUInt &other ) const{ return m_Limbs == other.m_Limbs; }
+
+	inline bool IsZero() const{ return m_Limbs.empty(); }
+	inline bool FitsUInt64() const{ return m_Limbs.size() <= 2; }
+
+	// @return the low 64 bits of the value, check FitsUInt64() first
+	uint64_t ToUInt64() const;
+	long double ToLongDouble() const;
+	std::string ToString() const;
+};
+
+// Triangle counts and areas of one deflate level, computed without generating the tilling
+struct LevelStats{
+	int level;
+	// Triangles with type 1, 36 degree at vertex a (half of a thin rhomb)
+	BigUInt thinTriangles;
+	// Triangles with type 2, 108 degree at vertex a (half of a thick rhomb)
+	BigUInt thickTriangles;
+	BigUInt totalTriangles;
+	long double thinArea;
+	long double thickArea;
+	long double totalArea;
+	// thick / thin, tends to PHI
+	long double thickThinRatio;
+};
+
+// Measures taken from the triangles of an actual tilling
+struct GeometricStats{
+	uint64_t thinTriangles;
+	uint64_t thickTriangles;
+	double thinArea;
+	double thickArea;
+	double totalArea;
+	uint64_t interiorVertices;
+	uint64_t boundaryVertices;
+	// Key is the sorted list of corners meeting at an interior vertex:
+	// 'a' thin apex (36), 'b' thin base (72), 'A' thick apex (108), 'B' thick base (36)
+	std::map<std::string, uint64_t> vertexConfigurations;
+};
+
+class PenroseStats{
+public:
+	/**
+	 * Counts and areas for levels 0..levels from the substitution matrix
+	 * thin' = thin + thick, thick' = thin + 2 * thick
+	 *
+	 * @param levels: Last level to compute
+	 * @param thin: Number of type 1 triangles at level 0
+	 * @param thick: Number of type 2 triangles at level 0
+	 * @param height: Length of the equal sides of the level 0 triangles
+	 */
+	static std::vector<LevelStats> Analytic( int levels, const BigUInt &thin, const BigUInt &thick, double height );
+
+	// @return the analytic stats for the levels 0..GetLoops() of p, using its seed triangles as level 0
+	static std::vector<LevelStats> Analytic( const Penrose &p );
+
+	/**
+	 * Counts, areas and vertex configurations of a list of triangles, split across threads
+	 *
+	 * @param triangles: Triangles of one level, flat ( before DoIt3D ), of any scalar PenroseT is instantiated with
+	 * @param threads: Number of workers, 0 for one per hardware thread
+	 */
+	template<typename T>
+	static GeometricStats Measure( const TriangleList<T> &triangles, unsigned int threads = 0 );
+
+	// @return Measure() of every level 0..levels of the tilling built from the given seed
+	static std::vector<GeometricStats> MeasureLevels( int levels, Coordinate origin, int degree, float height, unsigned int threads = 0 );
+};
@@ -0,0 +1,49 @@
+#include "ProcessMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+size_t PeakResidentBytes(){
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+		return counters.PeakWorkingSetSize;
+	return 0;
+#else
+	struct rusage usage;
+	if( getrusage( RUSAGE_SELF, &usage ) != 0 )
+		return 0;
+#ifdef __APPLE__
+	return ( size_t ) usage.ru_maxrss;
+#else
+	// Linux reports kilobytes
+	return ( size_t ) usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+size_t CurrentResidentBytes(){
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+		return counters.WorkingSetSize;
+	return 0;
+#else
+	FILE *file = fopen( "/proc/self/statm", "r" );
+	if( !file )
+		return 0;
+
+	unsigned long pages = 0, resident = 0;
+	int read = fscanf( file, "%lu %lu", &pages, &resident );
+	fclose( file );
+	return read == 2 ? ( size_t ) resident * ( size_t ) sysconf( _SC_PAGESIZE ) : 0;
+#endif
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstddef>
+
+// Memory of the running process as reported by the operating system, 0 when it can't be read
+
+// @return the largest resident set ( working set on Windows ) the process has had, in bytes
+size_t PeakResidentBytes();
+
+// @return the current resident set ( working set on Windows ), in bytes
+size_t CurrentResidentBytes();
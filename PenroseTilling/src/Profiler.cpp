@@ -0,0 +1,158 @@
+#include "Profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+namespace{
+
+const size_t CHUNK_EVENTS = 4096;
+// Events past CHUNK_EVENTS * MAX_CHUNKS on one thread are dropped
+const size_t MAX_CHUNKS = 1024;
+
+/*
+ * Events of one thread. Only the owner writes: it fills the slot and then publishes it by
+ * storing count with release, readers load count with acquire and never see a partial event.
+ * Chunks are never moved or freed, so a reader can keep walking them while the owner appends.
+ */
+struct ThreadBuffer{
+	uint32_t thread;
+	std::atomic<ProfileEvent *> chunks[ MAX_CHUNKS ];
+	std::atomic<size_t> count;
+	// First event that survived the last Clear
+	std::atomic<size_t> begin;
+	// Taken by a live thread, buffers of finished threads are handed to new ones
+	std::atomic<bool> inUse;
+
+	ThreadBuffer( uint32_t id )
+		: thread( id ), count( 0 ), begin( 0 ), inUse( true ){
+		for( std::atomic<ProfileEvent *> &chunk : chunks )
+			chunk.store( nullptr, std::memory_order_relaxed );
+	}
+
+	void Push( const ProfileEvent &event ){
+		size_t index = count.load( std::memory_order_relaxed );
+		size_t chunk = index / CHUNK_EVENTS;
+		if( chunk >= MAX_CHUNKS )
+			return;
+
+		ProfileEvent *events = chunks[ chunk ].load( std::memory_order_relaxed );
+		if( !events ){
+			events = new ProfileEvent[ CHUNK_EVENTS ];
+			chunks[ chunk ].store( events, std::memory_order_release );
+		}
+
+		events[ index % CHUNK_EVENTS ] = event;
+		events[ index % CHUNK_EVENTS ].thread = thread;
+		count.store( index + 1, std::memory_order_release );
+	}
+};
+
+// Registration is the only locked path, once per thread
+std::mutex &RegistryMutex(){
+	static std::mutex mutex;
+	return mutex;
+}
+
+std::vector<ThreadBuffer *> &Registry(){
+	static std::vector<ThreadBuffer *> buffers;
+	return buffers;
+}
+
+struct ThreadHandle{
+	ThreadBuffer *buffer = nullptr;
+
+	~ThreadHandle(){
+		if( buffer )
+			buffer->inUse.store( false, std::memory_order_release );
+	}
+};
+
+ThreadBuffer &LocalBuffer(){
+	thread_local ThreadHandle handle;
+	if( handle.buffer )
+		return *handle.buffer;
+
+	std::lock_guard<std::mutex> lock( RegistryMutex() );
+	for( ThreadBuffer *buffer : Registry() ){
+		if( !buffer->inUse.load( std::memory_order_acquire ) ){
+			buffer->inUse.store( true, std::memory_order_relaxed );
+			handle.buffer = buffer;
+			return *buffer;
+		}
+	}
+
+	handle.buffer = new ThreadBuffer( ( uint32_t ) Registry().size() );
+	Registry().push_back( handle.buffer );
+	return *handle.buffer;
+}
+
+std::chrono::steady_clock::time_point Epoch(){
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return epoch;
+}
+
+}
+
+uint64_t Profiler::Now(){
+	return ( uint64_t ) std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - Epoch() ).count();
+}
+
+void Profiler::RecordScope( const char *name, uint64_t start, uint64_t end ){
+	ProfileEvent event = { name, start, end - start, 0.0, 0, false };
+	LocalBuffer().Push( event );
+}
+
+void Profiler::RecordCounter( const char *name, double value ){
+	ProfileEvent event = { name, Now(), 0, value, 0, true };
+	LocalBuffer().Push( event );
+}
+
+std::vector<ProfileEvent> Profiler::Collect(){
+	std::vector<ThreadBuffer *> buffers;
+	{
+		std::lock_guard<std::mutex> lock( RegistryMutex() );
+		buffers = Registry();
+	}
+
+	std::vector<ProfileEvent> events;
+	for( ThreadBuffer *buffer : buffers ){
+		size_t end = buffer->count.load( std::memory_order_acquire );
+		for( size_t i = buffer->begin.load( std::memory_order_relaxed ); i < end; i++ )
+			events.push_back( buffer->chunks[ i / CHUNK_EVENTS ].load( std::memory_order_acquire )[ i % CHUNK_EVENTS ] );
+	}
+	return events;
+}
+
+void Profiler::Clear(){
+	std::lock_guard<std::mutex> lock( RegistryMutex() );
+	for( ThreadBuffer *buffer : Registry() )
+		buffer->begin.store( buffer->count.load( std::memory_order_acquire ), std::memory_order_relaxed );
+}
+
+bool Profiler::WriteChromeTrace( const std::string &path ){
+	FILE *file = fopen( path.c_str(), "w" );
+	if( !file )
+		return false;
+
+	std::vector<ProfileEvent> events = Collect();
+
+	// Timestamps are microseconds in the trace-event format
+	fprintf( file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+	for( size_t i = 0; i < events.size(); i++ ){
+		const ProfileEvent &e = events[ i ];
+		const char *separator = i ? "," : "";
+
+		if( e.counter ){
+			fprintf( file, "%s\n{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%.17g}}",
+				separator, e.name, e.start / 1000.0, e.thread, e.value );
+		} else{
+			fprintf( file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				separator, e.name, e.start / 1000.0, e.duration / 1000.0, e.thread );
+		}
+	}
+	fprintf( file, "\n]}\n" );
+
+	return fclose( file ) == 0;
+}
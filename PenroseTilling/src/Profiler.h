@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Scoped timers and counters for the hot paths. Every thread appends to its own buffer without
+ * locks, and the events can be collected at any time or dumped as Chrome trace-event JSON
+ * ( open it in chrome://tracing or ui.perfetto.dev ).
+ *
+ * Recording only happens when PENROSE_PROFILE is defined, otherwise PROFILE_SCOPE and
+ * PROFILE_COUNTER expand to nothing.
+ */
+
+struct ProfileEvent{
+	// Static string, the macros are only used with literals
+	const char *name;
+	// Nanoseconds since the first use of the profiler
+	uint64_t start;
+	uint64_t duration;
+	// Value of a counter, unused by scopes
+	double value;
+	uint32_t thread;
+	bool counter;
+};
+
+class Profiler{
+public:
+	// @return nanoseconds since the first use of the profiler
+	static uint64_t Now();
+
+	static void RecordScope( const char *name, uint64_t start, uint64_t end );
+	static void RecordCounter( const char *name, double value );
+
+	// @return a copy of the events of every thread recorded since the last Clear, in no particular order
+	static std::vector<ProfileEvent> Collect();
+
+	// Forget the recorded events, threads keep recording while it runs
+	static void Clear();
+
+	// @return false if the file can't be written
+	static bool WriteChromeTrace( const std::string &path );
+};
+
+// Records the time between its construction and destruction
+class ProfileScope{
+private:
+	const char *m_Name;
+	uint64_t m_Start;
+
+public:
+	ProfileScope( const char *name )
+		: m_Name( name ), m_Start( Profiler::Now() ){ }
+
+	~ProfileScope(){
+		Profiler::RecordScope( m_Name, m_Start, Profiler::Now() );
+	}
+
+	ProfileScope( const ProfileScope & ) = delete;
+	ProfileScope &operator=( const ProfileScope & ) = delete;
+};
+
+#ifdef PENROSE_PROFILE
+#define PROFILE_CONCAT_IMPL( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_IMPL( a, b )
+#define PROFILE_SCOPE( name ) ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( name )
+#define PROFILE_COUNTER( name, value ) Profiler::RecordCounter( name, ( double ) ( value ) )
+#else
+#define PROFILE_SCOPE( name )
+#define PROFILE_COUNTER( name, value )
+#endif
@@ -0,0 +1,133 @@
+#include "ProgramBinaryCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Renderer.h"
+#include "Profiler.h"
+
+const char *ProgramBinaryCache::DIRECTORY = "shadercache";
+
+namespace{
+
+// "PBIN", then the version of the layout of the file
+const uint32_t MAGIC = 0x4E494250;
+const uint32_t VERSION = 1;
+
+struct Header{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	// From glGetProgramBinary, for glProgramBinary
+	uint32_t format;
+	uint32_t size;
+};
+
+// FNV-1a of 64 bits
+uint64_t Hash( uint64_t hash, const char *data, size_t size ){
+	for( size_t i = 0; i < size; i++ ){
+		hash ^= ( unsigned char ) data[ i ];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+// With the terminator, so text moved from one string to the next changes the hash
+uint64_t Hash( uint64_t hash, const std::string &text ){
+	return Hash( hash, text.c_str(), text.size() + 1 );
+}
+
+uint64_t HashDriverString( uint64_t hash, GLenum name ){
+	GLCall( const GLubyte *value = glGetString( name ) );
+	return value ? Hash( hash, std::string( ( const char * ) value ) ) : hash;
+}
+
+std::string PathOf( uint64_t key ){
+	char name[ 17 ];
+	std::snprintf( name, sizeof( name ), "%016llx", ( unsigned long long ) key );
+	return std::string( ProgramBinaryCache::DIRECTORY ) + "/" + name + ".bin";
+}
+
+}
+
+uint64_t ProgramBinaryCache::Key( const std::string &vertexSource, const std::string &geometrySource, const std::string &fragmentSource ){
+	uint64_t hash = 0xCBF29CE484222325ull;
+	hash = Hash( hash, vertexSource );
+	hash = Hash( hash, geometrySource );
+	hash = Hash( hash, fragmentSource );
+	hash = HashDriverString( hash, GL_VENDOR );
+	hash = HashDriverString( hash, GL_RENDERER );
+	hash = HashDriverString( hash, GL_VERSION );
+	return hash;
+}
+
+unsigned int ProgramBinaryCache::Load( uint64_t key ){
+	PROFILE_SCOPE( "ProgramBinaryCache::Load" );
+	if( !IsSupported() )
+		return 0;
+
+	std::ifstream stream( PathOf( key ), std::ios::binary );
+	Header header;
+	if( !stream.read( ( char * ) &header, sizeof( header ) ) )
+		return 0;
+	if( header.magic != MAGIC || header.version != VERSION || header.key != key )
+		return 0;
+	std::vector<char> binary( header.size );
+	if( !stream.read( binary.data(), binary.size() ) )
+		return 0;
+
+	GLCall( unsigned int program = glCreateProgram() );
+	// Not in GLCall, a format the driver dropped is an error here but only means compiling again
+	glProgramBinary( program, header.format, binary.data(), ( int ) binary.size() );
+	GLClearError();
+
+	int linked = GL_FALSE;
+	GLCall( glGetProgramiv( program, GL_LINK_STATUS, &linked ) );
+	if( linked != GL_TRUE ){
+		GLCall( glDeleteProgram( program ) );
+		return 0;
+	}
+	return program;
+}
+
+bool ProgramBinaryCache::Save( uint64_t key, unsigned int program ){
+	PROFILE_SCOPE( "ProgramBinaryCache::Save" );
+	if( !IsSupported() )
+		return false;
+
+	int linked = GL_FALSE;
+	int length = 0;
+	GLCall( glGetProgramiv( program, GL_LINK_STATUS, &linked ) );
+	GLCall( glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length ) );
+	if( linked != GL_TRUE || length <= 0 )
+		return false;
+
+	std::vector<char> binary( length );
+	GLenum format = 0;
+	GLCall( glGetProgramBinary( program, length, &length, &format, binary.data() ) );
+
+	std::error_code error;
+	std::filesystem::create_directories( DIRECTORY, error );
+
+	// Written aside and renamed, so a launch never reads half a file
+	const std::string path = PathOf( key );
+	const std::string temporary = path + ".tmp";
+	{
+		std::ofstream stream( temporary, std::ios::binary );
+		Header header = { MAGIC, VERSION, key, ( uint32_t ) format, ( uint32_t ) length };
+		stream.write( ( const char * ) &header, sizeof( header ) );
+		stream.write( binary.data(), length );
+		if( !stream.good() )
+			return false;
+	}
+	std::filesystem::rename( temporary, path, error );
+	return !error;
+}
+
+bool ProgramBinaryCache::IsSupported(){
+	int formats = 0;
+	GLCall( glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats ) );
+	return formats > 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*
+ * Linked programs saved with glGetProgramBinary, so the next launch loads them with glProgramBinary
+ * instead of compiling the GLSL again. A program is found by a hash of its sources and of the vendor,
+ * renderer and version strings of the driver: editing a shader or updating the driver misses the cache,
+ * and a binary the driver still rejects is compiled again by the caller and saved over.
+ */
+class ProgramBinaryCache{
+public:
+	// Where the binaries go, relative to the working directory like res/
+	static const char *DIRECTORY;
+
+	// @return the key of the program linked from the sources with the driver of the current context
+	static uint64_t Key( const std::string &vertexSource, const std::string &geometrySource, const std::string &fragmentSource );
+
+	// @return a linked program, or 0 when the key isn't cached or the driver doesn't take the binary
+	static unsigned int Load( uint64_t key );
+
+	/**
+	 * Save a program linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	 *
+	 * @return whether the binary was written
+	 */
+	static bool Save( uint64_t key, unsigned int program );
+
+	// @return whether the driver has a binary format, the cache does nothing otherwise
+	static bool IsSupported();
+};
@@ -1,6 +1,12 @@
 #include "Renderer.h"
 #include <iostream>
 
+#include "Profiler.h"
+
+unsigned long long RenderStats::s_Triangles = 0;
+unsigned long long RenderStats::s_DrawCalls = 0;
+unsigned long long RenderStats::s_UploadedBytes = 0;
+
 void GLClearError(){
     while( glGetError() != GL_NO_ERROR );
 }
@@ -13,12 +19,24 @@ bool GLLogCall( const char *function, const char *file, int line ){
     return true;
 }
 
+void GLWaitFence( GLsync &fence ){
+    // The first wait flushes, otherwise the fence could still be in a queue the GPU never sees
+    GLenum status = glClientWaitSync( fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 );
+    while( status == GL_TIMEOUT_EXPIRED )
+        status = glClientWaitSync( fence, 0, 1000000000 );
+    ASSERT( status != GL_WAIT_FAILED );
+
+    GLCall( glDeleteSync( fence ) );
+    fence = nullptr;
+}
+
 void Renderer::Clear() const{
     GLCall( glEnable( GL_DEPTH_TEST ) );
     GLCall( glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT ) );
 }
 
 void Renderer::Draw( const VertexArray &va, const IndexBuffer &ib, const Shader &shader ) const{
+    PROFILE_SCOPE( "Renderer::Draw" );
 
     shader.Bind();
 
@@ -26,5 +44,19 @@ void Renderer::Draw( const VertexArray &va, const IndexBuffer &ib, const Shader
     ib.Bind();
 
     GLCall( glDrawElements( GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr ) );
+    RenderStats::AddDraw( ib.GetCount() / 3 );
+
+}
+
+void Renderer::DrawInstanced( const VertexArray &va, const IndexBuffer &ib, const Shader &shader, unsigned int instances, unsigned int baseInstance ) const{
+    PROFILE_SCOPE( "Renderer::DrawInstanced" );
+
+    shader.Bind();
+
+    va.Bind();
+    ib.Bind();
+
+    GLCall( glDrawElementsInstancedBaseInstance( GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr, instances, baseInstance ) );
+    RenderStats::AddDraw( ( unsigned long long ) ib.GetCount() / 3 * instances );
 
 }
\ No newline at end of file
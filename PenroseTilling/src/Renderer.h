@@ -5,16 +5,52 @@
 #include "VertexArray.h"
 #include "Shader.h"
 
-#define ASSERT(x) if ((!(x)) ) __debugbreak();
+// Stop in the debugger where the failing call is, __debugbreak only exists on MSVC
+#if defined( _MSC_VER )
+#define DEBUG_BREAK() __debugbreak()
+#elif defined( __GNUC__ ) || defined( __clang__ )
+#define DEBUG_BREAK() __builtin_trap()
+#else
+#include <cstdlib>
+#define DEBUG_BREAK() std::abort()
+#endif
+
+#define ASSERT(x) if ((!(x)) ) DEBUG_BREAK();
 #define GLCall(x) GLClearError(); \
 		x; \
 		ASSERT(GLLogCall(#x, __FILE__, __LINE__))
 
 void GLClearError();
 bool GLLogCall( const char *fucntion, const char *file, int line );
+// Block until the GPU went past the fence, then delete it and set it to null
+void GLWaitFence( GLsync &fence );
+
+// Work sent to the GPU since the last Reset, the profiler panel resets it every frame
+class RenderStats{
+private:
+	static unsigned long long s_Triangles;
+	static unsigned long long s_DrawCalls;
+	static unsigned long long s_UploadedBytes;
+
+public:
+	static inline void AddDraw( unsigned long long triangles ){ s_Triangles += triangles; s_DrawCalls++; }
+	static inline void AddUploadedBytes( unsigned long long bytes ){ s_UploadedBytes += bytes; }
+
+	static inline unsigned long long GetTriangles(){ return s_Triangles; }
+	static inline unsigned long long GetDrawCalls(){ return s_DrawCalls; }
+	static inline unsigned long long GetUploadedBytes(){ return s_UploadedBytes; }
+
+	static inline void Reset(){ s_Triangles = s_DrawCalls = s_UploadedBytes = 0; }
+};
 
 class Renderer{
 public:
 	void Clear() const;
 	void Draw( const VertexArray &va, const IndexBuffer &ib, const Shader &shader ) const;
+	/**
+	 * The mesh of the index buffer once per instance, va has the per instance attributes
+	 *
+	 * @param baseInstance: First instance read from the per instance attributes, like a section of a VertexBufferRing
+	 */
+	void DrawInstanced( const VertexArray &va, const IndexBuffer &ib, const Shader &shader, unsigned int instances, unsigned int baseInstance = 0 ) const;
 };
\ No newline at end of file
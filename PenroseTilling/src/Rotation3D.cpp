@@ -0,0 +1,122 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#include "Rotation3D.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define ROTATION3D_SSE
+#include <emmintrin.h>
+#endif
+
+#include "Parallel.h"
+
+Axis AxisFromName( const std::string &name ){
+	if( name == "X" ){
+		return Axis::X;
+	} else if( name == "Y" ){
+		return Axis::Y;
+	} else if( name == "Z" ){
+		return Axis::Z;
+	} else if( name == "XY" ){
+		return Axis::XY;
+	} else if( name == "XZ" ){
+		return Axis::XZ;
+	}
+
+	return Axis::YZ;
+}
+
+glm::vec3 AxisVector( Axis axis ){
+	switch( axis ){
+		case Axis::X:	return glm::vec3( 1, 0, 0 );
+		case Axis::Y:	return glm::vec3( 0, 1, 0 );
+		case Axis::Z:	return glm::vec3( 0, 0, 1 );
+		case Axis::XY:	return glm::vec3( 1, 1, 0 );
+		case Axis::XZ:	return glm::vec3( 1, 0, 1 );
+		case Axis::YZ:	return glm::vec3( 0, 1, 1 );
+	}
+
+	return glm::vec3( 0, 1, 1 );
+}
+
+Rotation3D::Rotation3D( Axis axis, double angle, glm::dvec3 origin ){
+	Init( glm::dvec3( AxisVector( axis ) ), angle, origin );
+}
+
+Rotation3D::Rotation3D( glm::dvec3 axis, double angle, glm::dvec3 origin ){
+	Init( axis, angle, origin );
+}
+
+void Rotation3D::Init( glm::dvec3 axis, double angle, glm::dvec3 origin ){
+	double rad = angle * M_PI / 180;
+
+	m_Matrix = glm::dmat3( glm::rotate( glm::dmat4( 1.0 ), rad, axis ) );
+	m_Origin = origin;
+
+	for( int row = 0; row < 3; row++ ){
+		for( int column = 0; column < 3; column++ )
+			m_Rows[ row * 3 + column ] = ( float ) m_Matrix[ column ][ row ];
+
+		m_OriginF[ row ] = ( float ) origin[ row ];
+	}
+}
+
+void Rotation3D::Apply( float *points, size_t count, size_t stride ) const{
+	const float *m = m_Rows;
+	const float ox = m_OriginF[ 0 ], oy = m_OriginF[ 1 ], oz = m_OriginF[ 2 ];
+	size_t i = 0;
+
+#ifdef ROTATION3D_SSE
+	// Four points per iteration, one SSE lane each
+	const __m128 m00 = _mm_set1_ps( m[ 0 ] ), m01 = _mm_set1_ps( m[ 1 ] ), m02 = _mm_set1_ps( m[ 2 ] );
+	const __m128 m10 = _mm_set1_ps( m[ 3 ] ), m11 = _mm_set1_ps( m[ 4 ] ), m12 = _mm_set1_ps( m[ 5 ] );
+	const __m128 m20 = _mm_set1_ps( m[ 6 ] ), m21 = _mm_set1_ps( m[ 7 ] ), m22 = _mm_set1_ps( m[ 8 ] );
+	const __m128 vox = _mm_set1_ps( ox ), voy = _mm_set1_ps( oy ), voz = _mm_set1_ps( oz );
+
+	for( ; i + 4 <= count; i += 4 ){
+		float *p0 = points + i * stride;
+		float *p1 = p0 + stride;
+		float *p2 = p1 + stride;
+		float *p3 = p2 + stride;
+
+		__m128 x = _mm_sub_ps( _mm_setr_ps( p0[ 0 ], p1[ 0 ], p2[ 0 ], p3[ 0 ] ), vox );
+		__m128 y = _mm_sub_ps( _mm_setr_ps( p0[ 1 ], p1[ 1 ], p2[ 1 ], p3[ 1 ] ), voy );
+		__m128 z = _mm_sub_ps( _mm_setr_ps( p0[ 2 ], p1[ 2 ], p2[ 2 ], p3[ 2 ] ), voz );
+
+		__m128 rx = _mm_add_ps( vox, _mm_add_ps( _mm_mul_ps( m00, x ), _mm_add_ps( _mm_mul_ps( m01, y ), _mm_mul_ps( m02, z ) ) ) );
+		__m128 ry = _mm_add_ps( voy, _mm_add_ps( _mm_mul_ps( m10, x ), _mm_add_ps( _mm_mul_ps( m11, y ), _mm_mul_ps( m12, z ) ) ) );
+		__m128 rz = _mm_add_ps( voz, _mm_add_ps( _mm_mul_ps( m20, x ), _mm_add_ps( _mm_mul_ps( m21, y ), _mm_mul_ps( m22, z ) ) ) );
+
+		alignas( 16 ) float outX[ 4 ], outY[ 4 ], outZ[ 4 ];
+		_mm_store_ps( outX, rx );
+		_mm_store_ps( outY, ry );
+		_mm_store_ps( outZ, rz );
+
+		float *targets[ 4 ] = { p0, p1, p2, p3 };
+		for( int lane = 0; lane < 4; lane++ ){
+			targets[ lane ][ 0 ] = outX[ lane ];
+			targets[ lane ][ 1 ] = outY[ lane ];
+			targets[ lane ][ 2 ] = outZ[ lane ];
+		}
+	}
+#endif
+
+	for( ; i < count; i++ ){
+		float *p = points + i * stride;
+		float x = p[ 0 ] - ox;
+		float y = p[ 1 ] - oy;
+		float z = p[ 2 ] - oz;
+
+		p[ 0 ] = ox + m[ 0 ] * x + m[ 1 ] * y + m[ 2 ] * z;
+		p[ 1 ] = oy + m[ 3 ] * x + m[ 4 ] * y + m[ 5 ] * z;
+		p[ 2 ] = oz + m[ 6 ] * x + m[ 7 ] * y + m[ 8 ] * z;
+	}
+}
+
+void Rotation3D::ApplyParallel( float *points, size_t count, size_t stride, unsigned int threads ) const{
+	ParallelFor( count, threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		Apply( points + begin * stride, end - begin, stride );
+	} );
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <glm/glm.hpp>
+
+// Axis a rotation can be done around, the diagonal ones are normalized
+enum class Axis{
+	X, Y, Z, XY, XZ, YZ
+};
+
+// @return the axis for the names used by Coordinate::RotatePoint3D ( X, Y, Z, XY, XZ, anything else is YZ )
+Axis AxisFromName( const std::string &name );
+
+// @return the direction of an axis, not normalized
+glm::vec3 AxisVector( Axis axis );
+
+/**
+ * Rotation around an axis passing through origin. The matrix is built once
+ * and then applied to single points or to whole vertex spans.
+ */
+class Rotation3D{
+private:
+	glm::dmat3 m_Matrix;
+	glm::dvec3 m_Origin;
+	// Row major copy of m_Matrix for the float kernel
+	float m_Rows[ 9 ];
+	float m_OriginF[ 3 ];
+
+public:
+	// @param angle: Degrees, counterclockwise looking from the tip of the axis
+	Rotation3D( Axis axis, double angle, glm::dvec3 origin = glm::dvec3( 0.0 ) );
+	Rotation3D( glm::dvec3 axis, double angle, glm::dvec3 origin = glm::dvec3( 0.0 ) );
+
+	// @return p rotated, Point is any type with x, y, z members and a ( x, y, z ) constructor
+	template<typename Point>
+	Point Apply( const Point &p ) const{
+		typedef decltype( p.x ) Scalar;
+
+		glm::dvec3 v( static_cast< double >( p.x ), static_cast< double >( p.y ), static_cast< double >( p.z ) );
+		glm::dvec3 r = m_Origin + m_Matrix * ( v - m_Origin );
+
+		return Point( Scalar( r.x ), Scalar( r.y ), Scalar( r.z ) );
+	}
+
+	/**
+	 * Rotate in place count points made of 3 consecutive floats, the first float of
+	 * each point is stride floats after the previous one ( 3 for packed positions,
+	 * 12 for the vertices of GetVerticesWithColorsTexCoordsAndNormalLight )
+	 */
+	void Apply( float *points, size_t count, size_t stride = 3 ) const;
+
+	// Same as Apply( points, count, stride ) with the span split across threads, 0 for one per hardware thread
+	void ApplyParallel( float *points, size_t count, size_t stride = 3, unsigned int threads = 0 ) const;
+
+	inline const glm::dmat3 &GetMatrix() const{ return m_Matrix; }
+
+private:
+	void Init( glm::dvec3 axis, double angle, glm::dvec3 origin );
+};
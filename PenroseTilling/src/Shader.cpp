@@ -6,14 +6,89 @@
 #include <sstream>
 
 #include "Renderer.h"
+#include "Profiler.h"
+#include "ProgramBinaryCache.h"
+
+namespace{
+
+bool IsSamplerType( unsigned int type ){
+	switch( type ){
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_INT_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+			return true;
+	}
+	return false;
+}
+
+// Whether glGetProgramiv can ask if a link is over without waiting for it
+bool HasParallelCompile(){
+	static const bool supported = [](){
+		if( GLEW_KHR_parallel_shader_compile ){
+			// As many threads as the driver wants
+			GLCall( glMaxShaderCompilerThreadsKHR( 0xFFFFFFFF ) );
+			return true;
+		}
+		if( GLEW_ARB_parallel_shader_compile ){
+			GLCall( glMaxShaderCompilerThreadsARB( 0xFFFFFFFF ) );
+			return true;
+		}
+		return false;
+	}();
+	return supported;
+}
+
+void PrintShaderLog( unsigned int id ){
+	int length = 0;
+	GLCall( glGetShaderiv( id, GL_INFO_LOG_LENGTH, &length ) );
+	if( length <= 1 )
+		return;
+	std::string message( length, '\0' );
+	GLCall( glGetShaderInfoLog( id, length, &length, &message[ 0 ] ) );
+	std::cout << message << std::endl;
+}
+
+}
 
-Shader::Shader( const std::string &filepath )
-	: m_FilePath(filepath), m_RenderID(0){
+ShaderDefines &ShaderDefines::Set( const std::string &name, int value ){
+	m_Values[ name ] = value;
+	return *this;
+}
+
+std::string ShaderDefines::GetSource() const{
+	std::string source;
+	for( const auto &define : m_Values )
+		source += "#define " + define.first + " " + std::to_string( define.second ) + "\n";
+	return source;
+}
+
+std::string ShaderDefines::GetKey() const{
+	std::string key;
+	for( const auto &define : m_Values )
+		key += define.first + "=" + std::to_string( define.second ) + ";";
+	return key;
+}
+
+Shader::Shader( const std::string &filepath, const std::string &vertexInputs, const ShaderDefines &defines )
+	: m_FilePath(filepath), m_VertexInputs( vertexInputs ), m_Defines( defines.GetSource() ), m_RenderID(0), m_Pending(){
 	ShaderProgramSource source = ParseShader( filepath );
-	m_RenderID = CreateShader( source.VertexSource, source.FragmentSource, source.GeometrySource );
+	// Parsing is still needed for the key, only the compilation is skipped
+	const uint64_t key = ProgramBinaryCache::Key( source.VertexSource, source.GeometrySource, source.FragmentSource );
+	m_RenderID = ProgramBinaryCache::Load( key );
+	if( !m_RenderID ){
+		m_RenderID = CreateShader( source.VertexSource, source.FragmentSource, source.GeometrySource );
+		ProgramBinaryCache::Save( key, m_RenderID );
+	}
+	ReflectUniforms();
 }
 
 Shader::~Shader(){
+	DiscardReload();
 	GLCall( glDeleteProgram( m_RenderID ) );
 }
 
@@ -25,7 +100,88 @@ void Shader::UnBind() const{
 	GLCall( glUseProgram( 0 ) );
 }
 
+void Shader::BeginReload(){
+	PROFILE_SCOPE( "Shader::BeginReload" );
+	DiscardReload();
+	HasParallelCompile();
+
+	ShaderProgramSource source = ParseShader( m_FilePath );
+	m_Pending.key = ProgramBinaryCache::Key( source.VertexSource, source.GeometrySource, source.FragmentSource );
+	const unsigned int types[ 3 ] = { GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER };
+	const std::string *sources[ 3 ] = { &source.VertexSource, &source.GeometrySource, &source.FragmentSource };
+
+	// Nothing asks for a status here, which is what would wait for the compiler
+	GLCall( m_Pending.program = glCreateProgram() );
+	for( int i = 0; i < 3; i++ ){
+		GLCall( m_Pending.stages[ i ] = glCreateShader( types[ i ] ) );
+		const char *src = sources[ i ]->c_str();
+		GLCall( glShaderSource( m_Pending.stages[ i ], 1, &src, nullptr ) );
+		GLCall( glCompileShader( m_Pending.stages[ i ] ) );
+		GLCall( glAttachShader( m_Pending.program, m_Pending.stages[ i ] ) );
+	}
+	GLCall( glProgramParameteri( m_Pending.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE ) );
+	GLCall( glLinkProgram( m_Pending.program ) );
+}
+
+bool Shader::PollReload(){
+	if( !m_Pending.program )
+		return false;
+
+	// Without the extension the status below waits, for one frame and only after an edit
+	if( HasParallelCompile() ){
+		int completed = GL_FALSE;
+		GLCall( glGetProgramiv( m_Pending.program, GL_COMPLETION_STATUS_KHR, &completed ) );
+		if( completed == GL_FALSE )
+			return false;
+	}
+
+	PROFILE_SCOPE( "Shader::PollReload" );
+	int linked = GL_FALSE;
+	GLCall( glGetProgramiv( m_Pending.program, GL_LINK_STATUS, &linked ) );
+	if( linked != GL_TRUE ){
+		std::cout << "Failed to reload " << m_FilePath << ", the previous program stays" << std::endl;
+		for( unsigned int stage : m_Pending.stages )
+			PrintShaderLog( stage );
+
+		int length = 0;
+		GLCall( glGetProgramiv( m_Pending.program, GL_INFO_LOG_LENGTH, &length ) );
+		if( length > 1 ){
+			std::string message( length, '\0' );
+			GLCall( glGetProgramInfoLog( m_Pending.program, length, &length, &message[ 0 ] ) );
+			std::cout << message << std::endl;
+		}
+		DiscardReload();
+		return false;
+	}
+
+	const unsigned int program = m_Pending.program;
+	const uint64_t key = m_Pending.key;
+	m_Pending.program = 0;
+	DiscardReload();
+
+	GLCall( glDeleteProgram( m_RenderID ) );
+	m_RenderID = program;
+	ProgramBinaryCache::Save( key, m_RenderID );
+	m_UniformLocationCache.clear();
+	ReflectUniforms();
+	return true;
+}
+
+void Shader::DiscardReload(){
+	for( unsigned int &stage : m_Pending.stages ){
+		if( stage ){
+			GLCall( glDeleteShader( stage ) );
+		}
+		stage = 0;
+	}
+	if( m_Pending.program ){
+		GLCall( glDeleteProgram( m_Pending.program ) );
+	}
+	m_Pending.program = 0;
+}
+
 ShaderProgramSource Shader::ParseShader( const std::string &filepath ){
+	PROFILE_SCOPE( "Shader::ParseShader" );
 	std::fstream stream( filepath );
 
 	enum class ShaderType{
@@ -36,6 +192,13 @@ ShaderProgramSource Shader::ParseShader( const std::string &filepath ){
 	std::stringstream ss[ 3 ];
 	ShaderType type = ShaderType::NONE;
 
+	// The #define lines of the vertex inputs, without the declarations only the vertex stage can have
+	std::string vertexDefines;
+	std::istringstream inputs( m_VertexInputs );
+	while( getline( inputs, line ) )
+		if( line.compare( 0, 7, "#define" ) == 0 )
+			vertexDefines += line + '\n';
+
 	while( getline( stream, line ) ){
 
 		if( line.find( "#shader" ) != std::string::npos ){
@@ -52,6 +215,15 @@ ShaderProgramSource Shader::ParseShader( const std::string &filepath ){
 			}
 		} else{
 			ss[ ( int ) type ] << line << '\n';
+
+			// Nothing but comments may come before #version
+			if( line.find( "#version" ) != std::string::npos ){
+				ss[ ( int ) type ] << m_Defines;
+				if( type == ShaderType::VERTEX )
+					ss[ ( int ) type ] << m_VertexInputs;
+				else
+					ss[ ( int ) type ] << vertexDefines;
+			}
 		}
 
 	}
@@ -60,6 +232,7 @@ ShaderProgramSource Shader::ParseShader( const std::string &filepath ){
 }
 
 unsigned int Shader::CompileShader( unsigned int type, const std::string &source ){
+	PROFILE_SCOPE( "Shader::CompileShader" );
 	GLCall( unsigned int id = glCreateShader( type ) );
 	const char *src = source.c_str();
 	GLCall( glShaderSource( id, 1, &src, nullptr ) );
@@ -92,12 +265,17 @@ unsigned int Shader::CreateShader( const std::string &vertexShader, const std::s
 	GLCall( glAttachShader( program, vs ) );
 	GLCall( glAttachShader( program, fs ) );
 	GLCall( glAttachShader( program, gs ) );
-	GLCall( glLinkProgram( program ) );
-	GLCall( glValidateProgram( program ) );
+	// So ProgramBinaryCache can save it
+	GLCall( glProgramParameteri( program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE ) );
+	{
+		PROFILE_SCOPE( "Shader::Link" );
+		GLCall( glLinkProgram( program ) );
+		GLCall( glValidateProgram( program ) );
+	}
 
 	GLCall( glDeleteShader( vs ) );
 	GLCall( glDeleteShader( fs ) );
-	GLCall( glDeleteShader( fs ) );
+	GLCall( glDeleteShader( gs ) );
 
 	return program;
 }
@@ -116,22 +294,27 @@ int Shader::GetUniformLocation( const std::string &name ){
 
 void Shader::Setuniforms1i( const std::string &name, int value ){
 	GLCall( glUniform1i( GetUniformLocation( name ), value ) );
+	RenderStats::AddUploadedBytes( sizeof( int ) );
 }
 
 void Shader::Setuniforms1iv( const std::string &name, int value, int *values ){
 	GLCall( glUniform1iv( GetUniformLocation( name ), value, values ) );
+	RenderStats::AddUploadedBytes( value * sizeof( int ) );
 }
 
 void Shader::SetUniformFloat( const std::string &name, float value ){
 	GLCall( glUniform1f( GetUniformLocation( name ), value ) );
+	RenderStats::AddUploadedBytes( sizeof( float ) );
 }
 
 void Shader::Setuniforms4f( const std::string &name, float v0, float v1, float v2, float v3 ){
 	GLCall( glUniform4f( GetUniformLocation( name ), v0, v1, v2, v3 ) );
+	RenderStats::AddUploadedBytes( 4 * sizeof( float ) );
 }
 
 void Shader::SetuniformsVec3( const std::string &name, glm::vec3 value ){
 	GLCall( glUniform3fv( GetUniformLocation( name ), 1, &value[ 0 ] ) );
+	RenderStats::AddUploadedBytes( sizeof( glm::vec3 ) );
 }
 
 void Shader::SetUniformsMat4( const std::string &name, glm::mat4 uniform_1, int transpose ){
@@ -141,9 +324,129 @@ void Shader::SetUniformsMat4( const std::string &name, glm::mat4 uniform_1, int
 	} else{
 		GLCall( glUniformMatrix4fv( GetUniformLocation( name ), 1, GL_FALSE, glm::value_ptr( uniform_1 ) ) );
 	}
+	RenderStats::AddUploadedBytes( sizeof( glm::mat4 ) );
 
 }
 
 void Shader::SetuniformsMat4f( const std::string &name, const glm::mat4 &mat4 ){
 	GLCall( glUniformMatrix4fv( GetUniformLocation( name ), 1, GL_FALSE, &mat4[ 0 ][ 0 ] ) );
+	RenderStats::AddUploadedBytes( sizeof( glm::mat4 ) );
+}
+
+void Shader::SetUniformBlockBinding( const std::string &name, unsigned int binding ){
+	GLCall( unsigned int index = glGetUniformBlockIndex( m_RenderID, name.c_str() ) );
+	if( index == GL_INVALID_INDEX ){
+		std::cout << "Warning: uniform block '" << name << "' doesn't exists!" << std::endl;
+		return;
+	}
+	GLCall( glUniformBlockBinding( m_RenderID, index, binding ) );
+}
+
+void Shader::ReflectUniforms(){
+	PROFILE_SCOPE( "Shader::ReflectUniforms" );
+	m_ActiveUniforms.clear();
+
+	int numUniforms = 0;
+	int maxLength = 0;
+	GLCall( glGetProgramiv( m_RenderID, GL_ACTIVE_UNIFORMS, &numUniforms ) );
+	GLCall( glGetProgramiv( m_RenderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength ) );
+
+	std::vector<char> name( maxLength + 1 );
+	for( int i = 0; i < numUniforms; i++ ){
+		int length = 0;
+		int count = 0;
+		unsigned int type = 0;
+		GLCall( glGetActiveUniform( m_RenderID, ( unsigned int ) i, ( int ) name.size(), &length, &count, &type, name.data() ) );
+
+		// Members of the uniform blocks have no location, UniformBuffer sets them
+		GLCall( int location = glGetUniformLocation( m_RenderID, name.data() ) );
+		if( location == -1 )
+			continue;
+
+		std::string uniformName( name.data(), length );
+		if( uniformName.size() > 3 && uniformName.compare( uniformName.size() - 3, 3, "[0]" ) == 0 )
+			uniformName.resize( uniformName.size() - 3 );
+		m_ActiveUniforms.push_back( { uniformName, location, type, count } );
+	}
+
+	// Linked again, what the slots held is gone
+	for( UniformSlot &slot : m_UniformSlots ){
+		slot.location = -1;
+		slot.hasValue = false;
+		for( const ActiveUniform &uniform : m_ActiveUniforms ){
+			if( uniform.name == slot.name ){
+				slot.location = uniform.location;
+				break;
+			}
+		}
+	}
+}
+
+int Shader::AddUniformSlot( const std::string &name, unsigned int type, unsigned int size ){
+	for( int i = 0; i < ( int ) m_UniformSlots.size(); i++ ){
+		if( m_UniformSlots[ i ].name == name ){
+			ASSERT( m_UniformSlots[ i ].type == type );
+			return i;
+		}
+	}
+
+	UniformSlot slot = { name, -1, type, ( unsigned int ) m_UniformShadow.size(), false, false };
+	for( const ActiveUniform &uniform : m_ActiveUniforms ){
+		if( uniform.name == name ){
+			// The handle sets the first element of an array
+			ASSERT( uniform.type == type || ( type == GL_INT && IsSamplerType( uniform.type ) ) );
+			slot.location = uniform.location;
+			break;
+		}
+	}
+	if( slot.location == -1 )
+		std::cout << "Warning: uniform '" << name << "' isn't active in " << m_FilePath << std::endl;
+
+	m_UniformShadow.resize( m_UniformShadow.size() + size );
+	m_UniformSlots.push_back( slot );
+	return ( int ) m_UniformSlots.size() - 1;
+}
+
+bool Shader::IsUniformActive( const std::string &name ) const{
+	for( const ActiveUniform &uniform : m_ActiveUniforms )
+		if( uniform.name == name )
+			return true;
+	return false;
+}
+
+void Shader::ReportInactiveUniform( UniformSlot &slot ){
+	if( slot.reported )
+		return;
+	std::cout << "Warning: uniform '" << slot.name << "' is set but not active in " << m_FilePath << std::endl;
+	slot.reported = true;
+}
+
+void Shader::UploadUniform( int location, int value ){
+	GLCall( glProgramUniform1i( m_RenderID, location, value ) );
+	RenderStats::AddUploadedBytes( sizeof( int ) );
+}
+
+void Shader::UploadUniform( int location, float value ){
+	GLCall( glProgramUniform1f( m_RenderID, location, value ) );
+	RenderStats::AddUploadedBytes( sizeof( float ) );
+}
+
+void Shader::UploadUniform( int location, const glm::vec2 &value ){
+	GLCall( glProgramUniform2fv( m_RenderID, location, 1, &value[ 0 ] ) );
+	RenderStats::AddUploadedBytes( sizeof( glm::vec2 ) );
+}
+
+void Shader::UploadUniform( int location, const glm::vec3 &value ){
+	GLCall( glProgramUniform3fv( m_RenderID, location, 1, &value[ 0 ] ) );
+	RenderStats::AddUploadedBytes( sizeof( glm::vec3 ) );
+}
+
+void Shader::UploadUniform( int location, const glm::vec4 &value ){
+	GLCall( glProgramUniform4fv( m_RenderID, location, 1, &value[ 0 ] ) );
+	RenderStats::AddUploadedBytes( sizeof( glm::vec4 ) );
+}
+
+void Shader::UploadUniform( int location, const glm::mat4 &value ){
+	GLCall( glProgramUniformMatrix4fv( m_RenderID, location, 1, GL_FALSE, &value[ 0 ][ 0 ] ) );
+	RenderStats::AddUploadedBytes( sizeof( glm::mat4 ) );
 }
\ No newline at end of file
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <map>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -12,19 +17,110 @@ struct ShaderProgramSource{
 	std::string GeometrySource;
 };
 
+/*
+ * #define lines put after the #version of every stage, to compile a variant of a shader. They are kept
+ * sorted by name, so the same defines give the same key in whatever order they were set.
+ */
+class ShaderDefines{
+private:
+	std::map<std::string, int> m_Values;
+
+public:
+	ShaderDefines &Set( const std::string &name, int value );
+
+	// @return the #define lines
+	std::string GetSource() const;
+	// @return the name of the variant, like "EXPLODE=1;NR_POINT_LIGHTS=2;", empty without defines
+	std::string GetKey() const;
+};
+
+// GL type of the uniforms a Uniform<T> sets, an int also sets samplers
+template<typename T> struct UniformTraits;
+template<> struct UniformTraits<int>{ static const unsigned int TYPE = GL_INT; };
+template<> struct UniformTraits<float>{ static const unsigned int TYPE = GL_FLOAT; };
+template<> struct UniformTraits<glm::vec2>{ static const unsigned int TYPE = GL_FLOAT_VEC2; };
+template<> struct UniformTraits<glm::vec3>{ static const unsigned int TYPE = GL_FLOAT_VEC3; };
+template<> struct UniformTraits<glm::vec4>{ static const unsigned int TYPE = GL_FLOAT_VEC4; };
+template<> struct UniformTraits<glm::mat4>{ static const unsigned int TYPE = GL_FLOAT_MAT4; };
+
+template<typename T>
+class Uniform;
+
 class Shader{
+public:
+	// A uniform of the default block found after linking, the members of uniform blocks aren't listed
+	struct ActiveUniform{
+		// Without the [0] of arrays
+		std::string name;
+		int location;
+		unsigned int type;
+		// Elements of an array, 1 otherwise
+		int count;
+	};
+
 private:
+	// A uniform handed out by GetUniform, with the last value set through it
+	struct UniformSlot{
+		std::string name;
+		// -1 while the uniform isn't active in the program
+		int location;
+		unsigned int type;
+		unsigned int shadowOffset;
+		bool hasValue;
+		bool reported;
+	};
+
+	// Program of a hot reload being compiled while the current one keeps drawing, see BeginReload
+	struct PendingProgram{
+		unsigned int program;
+		// Vertex, geometry and fragment
+		unsigned int stages[ 3 ];
+		// For ProgramBinaryCache
+		uint64_t key;
+	};
+
 	std::string m_FilePath;
+	// Inserted after the #version line of the vertex shader, see GlslVertexInputs. Its HAS_ defines go
+	// in the other stages too, so they can tell what the vertex shader has to pass on
+	std::string m_VertexInputs;
+	// Inserted after the #version line of every stage, before the vertex inputs
+	std::string m_Defines;
 	unsigned int m_RenderID;
+	PendingProgram m_Pending;
 	std::unordered_map<std::string, int> m_UniformLocationCache;
+	std::vector<ActiveUniform> m_ActiveUniforms;
+	std::vector<UniformSlot> m_UniformSlots;
+	// Values of the slots, each at its shadowOffset
+	std::vector<unsigned char> m_UniformShadow;
 
 public:
-	Shader( const std::string &filepath );
+	/**
+	 * @param filepath: File with the #shader vertex, geometry and fragment sections
+	 * @param vertexInputs: Attribute declarations of the vertex shader, generated from the vertex format
+	 * @param defines: Features of the variant, see ShaderVariants
+	 */
+	Shader( const std::string &filepath, const std::string &vertexInputs = "", const ShaderDefines &defines = ShaderDefines() );
 	~Shader();
 
 	void Bind() const;
 	void UnBind() const;
 
+	/**
+	 * Read the file again and start compiling it, for hot reload. With KHR_parallel_shader_compile the
+	 * driver compiles on its own threads and nothing here waits for it. The current program keeps drawing
+	 * until PollReload finds the new one linked, a reload already started is dropped
+	 */
+	void BeginReload();
+	/**
+	 * Swap in the program of BeginReload once it's linked, between two frames so no draw sees half of it.
+	 * A program that didn't compile or link is dropped with its log and the current one stays
+	 *
+	 * @return true when the program was swapped, its uniforms are reflected again and the handles follow
+	 * them, but the uniform block bindings and samplers have to be set again
+	 */
+	bool PollReload();
+	inline bool IsReloading() const{ return m_Pending.program != 0; }
+
 	// Set Uniforms
 	// Set Uniforms
 	void Setuniforms1i( const std::string &name, int value );
@@ -34,10 +130,93 @@ public:
 	void SetuniformsVec3( const std::string &name, glm::vec3 value );
 	void SetUniformsMat4( const std::string &name, glm::mat4 uniform_1, int transpose );
 	void SetuniformsMat4f( const std::string &name, const glm::mat4 &mat4 );
+	// Read the uniform block of the program from the UniformBuffer at the binding point
+	void SetUniformBlockBinding( const std::string &name, unsigned int binding );
+
+	/**
+	 * Resolve a uniform once, to set it every frame without looking its name up. The handle stays
+	 * valid for the life of the shader, a uniform that isn't active gives a handle setting nothing.
+	 * Values set through the string setters above aren't seen by the handles of the same uniform
+	 *
+	 * @param name: Name of the uniform, without [0] for an array
+	 */
+	template<typename T>
+	Uniform<T> GetUniform( const std::string &name ){
+		return Uniform<T>( this, AddUniformSlot( name, UniformTraits<T>::TYPE, sizeof( T ) ) );
+	}
+
+	// @return the uniforms the program uses, as reflected when it was linked
+	inline const std::vector<ActiveUniform> &GetActiveUniforms() const{ return m_ActiveUniforms; }
+	// @return whether the uniform is used by the program, a variant can leave it out
+	bool IsUniformActive( const std::string &name ) const;
 
 private:
 	ShaderProgramSource ParseShader( const std::string &filepath );
 	unsigned int CompileShader( unsigned int type, const std::string &source );
 	unsigned int CreateShader( const std::string &vertexShader, const std::string &fragmentShader, const std::string &geometryShader );
+	// Delete the program of BeginReload and its stages
+	void DiscardReload();
 	int GetUniformLocation( const std::string &name );
+
+	// List the active uniforms into m_ActiveUniforms and resolve the slots against them
+	void ReflectUniforms();
+	// @return the slot of the uniform, the same one for every GetUniform of a name
+	int AddUniformSlot( const std::string &name, unsigned int type, unsigned int size );
+	void ReportInactiveUniform( UniformSlot &slot );
+
+	// Nothing when the value is the last one set, compared with the shadow copy of the slot
+	template<typename T>
+	void SetUniform( int slot, const T &value ){
+		UniformSlot &uniform = m_UniformSlots[ slot ];
+		if( uniform.location == -1 ){
+#ifdef PENROSE_UNIFORM_DEBUG
+			ReportInactiveUniform( uniform );
+#endif
+			return;
+		}
+
+		unsigned char *shadow = m_UniformShadow.data() + uniform.shadowOffset;
+		if( uniform.hasValue && std::memcmp( shadow, &value, sizeof( T ) ) == 0 )
+			return;
+		std::memcpy( shadow, &value, sizeof( T ) );
+		uniform.hasValue = true;
+		UploadUniform( uniform.location, value );
+	}
+
+	// glProgramUniform, so the program doesn't have to be bound
+	void UploadUniform( int location, int value );
+	void UploadUniform( int location, float value );
+	void UploadUniform( int location, const glm::vec2 &value );
+	void UploadUniform( int location, const glm::vec3 &value );
+	void UploadUniform( int location, const glm::vec4 &value );
+	void UploadUniform( int location, const glm::mat4 &value );
+
+	template<typename T>
+	friend class Uniform;
+};
+
+/*
+ * Typed handle of a uniform from Shader::GetUniform. Setting it goes straight to the location reflected
+ * at link time, with no hashing nor string, and is skipped when the uniform already has the value.
+ */
+template<typename T>
+class Uniform{
+private:
+	Shader *m_Shader;
+	int m_Slot;
+
+public:
+	Uniform()
+		: m_Shader( nullptr ), m_Slot( -1 ){ }
+	Uniform( Shader *shader, int slot )
+		: m_Shader( shader ), m_Slot( slot ){ }
+
+	// Does nothing on a default constructed handle
+	void Set( const T &value ) const{
+		if( !m_Shader )
+			return;
+		m_Shader->SetUniform( m_Slot, value );
+	}
+
+	inline bool IsActive() const{ return m_Shader && m_Shader->m_UniformSlots[ m_Slot ].location != -1; }
 };
\ No newline at end of file
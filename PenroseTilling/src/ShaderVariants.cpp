@@ -0,0 +1,50 @@
+#include "ShaderVariants.h"
+
+#include <iostream>
+
+#include "Profiler.h"
+
+ShaderVariants::ShaderVariants( const std::string &filepath, const std::string &vertexInputs, std::function<void( Shader & )> setup )
+	: m_FilePath( filepath ), m_VertexInputs( vertexInputs ), m_Setup( std::move( setup ) ){
+	std::error_code error;
+	m_WriteTime = std::filesystem::last_write_time( m_FilePath, error );
+}
+
+Shader &ShaderVariants::Get( const ShaderDefines &defines ){
+	const std::string key = defines.GetKey();
+	auto found = m_Variants.find( key );
+	if( found != m_Variants.end() )
+		return *found->second;
+
+	PROFILE_SCOPE( "ShaderVariants::Compile" );
+	std::unique_ptr<Shader> shader( new Shader( m_FilePath, m_VertexInputs, defines ) );
+	if( m_Setup )
+		m_Setup( *shader );
+	std::cout << "Shader variant " << ( key.empty() ? "default" : key ) << " of " << m_FilePath << std::endl;
+
+	Shader &variant = *shader;
+	m_Variants.emplace( key, std::move( shader ) );
+	return variant;
+}
+
+int ShaderVariants::Poll(){
+	// A stat per frame, the file is only read when it was saved
+	std::error_code error;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time( m_FilePath, error );
+	if( !error && writeTime != m_WriteTime ){
+		m_WriteTime = writeTime;
+		for( auto &variant : m_Variants )
+			variant.second->BeginReload();
+	}
+
+	int swapped = 0;
+	for( auto &variant : m_Variants ){
+		if( !variant.second->PollReload() )
+			continue;
+		if( m_Setup )
+			m_Setup( *variant.second );
+		std::cout << "Reloaded shader variant " << ( variant.first.empty() ? "default" : variant.first ) << " of " << m_FilePath << std::endl;
+		swapped++;
+	}
+	return swapped;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "Shader.h"
+
+/*
+ * The variants of one shader file, each compiled with its own ShaderDefines the first time it's asked for
+ * and kept by the key of its defines. Switching back to a variant already used costs a lookup, and with
+ * ProgramBinaryCache the variants of earlier launches aren't compiled again either.
+ *
+ * Poll watches the file and reloads every variant when it's saved, see Shader::BeginReload.
+ */
+class ShaderVariants{
+private:
+	std::string m_FilePath;
+	std::string m_VertexInputs;
+	// Run on every new variant, for the bindings and uniforms set once
+	std::function<void( Shader & )> m_Setup;
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Variants;
+	// Of the file when the variants were last compiled
+	std::filesystem::file_time_type m_WriteTime;
+
+public:
+	/**
+	 * @param vertexInputs: Same for every variant, see Shader
+	 * @param setup: Called with each variant once compiled
+	 */
+	ShaderVariants( const std::string &filepath, const std::string &vertexInputs, std::function<void( Shader & )> setup = nullptr );
+
+	// @return the variant with the defines, compiled if it's the first time
+	Shader &Get( const ShaderDefines &defines );
+
+	/**
+	 * Once per frame, before Get. Starts reloading the variants when the file changed since they were
+	 * compiled, and swaps in the ones the driver finished with
+	 *
+	 * @return the variants swapped in this frame
+	 */
+	int Poll();
+
+	inline size_t GetNumVariants() const{ return m_Variants.size(); }
+};
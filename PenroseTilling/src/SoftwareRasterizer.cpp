@@ -0,0 +1,442 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define RASTERIZER_SSE
+#include <emmintrin.h>
+#endif
+
+#include "stb_image/stb_image.h"
+
+#include "ImageWriter.h"
+#include "Parallel.h"
+
+bool RasterTexture::Load( const std::string &path ){
+	int bpp = 0;
+	stbi_set_flip_vertically_on_load( 1 );
+	unsigned char *buffer = stbi_load( path.c_str(), &width, &height, &bpp, 4 );
+
+	if( !buffer ){
+		std::cout << "\nError: Failed to load texture " << path << std::endl;
+		std::cout << stbi_failure_reason() << std::endl;
+		return false;
+	}
+
+	pixels.assign( buffer, buffer + ( size_t ) width * height * 4 );
+	stbi_image_free( buffer );
+	return true;
+}
+
+glm::vec3 RasterTexture::Sample( glm::vec2 uv ) const{
+	if( pixels.empty() )
+		return glm::vec3( 0.0f );
+
+	// Texel centers are at half integers, like GL_LINEAR
+	float x = glm::clamp( uv.x * width - 0.5f, 0.0f, ( float ) ( width - 1 ) );
+	float y = glm::clamp( uv.y * height - 0.5f, 0.0f, ( float ) ( height - 1 ) );
+	int x0 = ( int ) x, y0 = ( int ) y;
+	int x1 = std::min( x0 + 1, width - 1 ), y1 = std::min( y0 + 1, height - 1 );
+	float fx = x - x0, fy = y - y0;
+
+	auto texel = [ & ]( int tx, int ty ){
+		const uint8_t *p = &pixels[ ( ( size_t ) ty * width + tx ) * 4 ];
+		return glm::vec3( p[ 0 ], p[ 1 ], p[ 2 ] ) / 255.0f;
+	};
+
+	glm::vec3 top = glm::mix( texel( x0, y0 ), texel( x1, y0 ), fx );
+	glm::vec3 bottom = glm::mix( texel( x0, y1 ), texel( x1, y1 ), fx );
+	return glm::mix( top, bottom, fy );
+}
+
+namespace{
+
+// Outputs of the vertex stage of project.shader
+struct ShadedVertex{
+	glm::vec4 clip;
+	glm::vec3 fragPos;
+	glm::vec2 texCoord;
+	float texIndex;
+	glm::vec3 normal;
+};
+
+// Edge functions E( p ) = A * x + B * y + C, positive inside, one per edge opposite to each vertex
+struct TriangleSetup{
+	uint32_t v[ 3 ];
+	float A[ 3 ], B[ 3 ], C[ 3 ];
+	bool topLeft[ 3 ];
+	float invArea;
+	// Window depth and 1 / w of each corner after the geometry stage
+	float z[ 3 ];
+	float invW[ 3 ];
+	int minX, minY, maxX, maxY;
+};
+
+// Marks the index of a vertex made by near plane clipping, it's in Bins::clipped instead of the vertex stage outputs
+const uint32_t CLIPPED_VERTEX = 0x80000000u;
+
+struct Bins{
+	std::vector<TriangleSetup> setups;
+	// Vertices where clipped triangles cross the near plane
+	std::vector<ShadedVertex> clipped;
+	// Index into setups, per screen tile, in submission order
+	std::vector<std::vector<uint32_t>> tiles;
+};
+
+// The vertex at s of the way from a to b, every output is linear in clip space
+ShadedVertex Mix( const ShadedVertex &a, const ShadedVertex &b, float s ){
+	ShadedVertex out;
+	out.clip = glm::mix( a.clip, b.clip, s );
+	out.fragPos = glm::mix( a.fragPos, b.fragPos, s );
+	out.texCoord = glm::mix( a.texCoord, b.texCoord, s );
+	out.texIndex = a.texIndex + ( b.texIndex - a.texIndex ) * s;
+	out.normal = glm::mix( a.normal, b.normal, s );
+	return out;
+}
+
+glm::vec3 Reflect( glm::vec3 incident, glm::vec3 normal ){
+	return incident - 2.0f * glm::dot( normal, incident ) * normal;
+}
+
+// Same as CalcDirLight, CalcPointLight and CalcSpotLight in project.shader
+glm::vec3 CalcDirLight( const DirLight &light, const Material &material, glm::vec3 texel, glm::vec3 normal, glm::vec3 viewDir ){
+	glm::vec3 lightDir = glm::normalize( -light.direction );
+	float diff = std::max( glm::dot( normal, lightDir ), 0.0f );
+	glm::vec3 reflectDir = Reflect( -lightDir, normal );
+	float spec = powf( std::max( glm::dot( viewDir, reflectDir ), 0.0f ), material.shininess );
+
+	return light.ambient * texel + light.diffuse * diff * texel + light.specular * spec * material.specular;
+}
+
+glm::vec3 CalcPointLight( const PointLight &light, const Material &material, glm::vec3 texel, glm::vec3 normal, glm::vec3 fragPos, glm::vec3 viewDir ){
+	glm::vec3 lightDir = glm::normalize( light.position - fragPos );
+	float diff = std::max( glm::dot( normal, lightDir ), 0.0f );
+	glm::vec3 reflectDir = Reflect( -lightDir, normal );
+	float spec = powf( std::max( glm::dot( viewDir, reflectDir ), 0.0f ), material.shininess );
+	float distance = glm::length( light.position - fragPos );
+	float attenuation = 1.0f / ( light.constant + light.linear * distance + light.quadratic * ( distance * distance ) );
+
+	return ( light.ambient * texel + light.diffuse * diff * texel + light.specular * spec * material.specular ) * attenuation;
+}
+
+glm::vec3 CalcSpotLight( const SpotLight &light, const Material &material, glm::vec3 texel, glm::vec3 normal, glm::vec3 fragPos, glm::vec3 viewDir ){
+	glm::vec3 lightDir = glm::normalize( light.position - fragPos );
+	float diff = std::max( glm::dot( normal, lightDir ), 0.0f );
+	glm::vec3 reflectDir = Reflect( -lightDir, normal );
+	float spec = powf( std::max( glm::dot( viewDir, reflectDir ), 0.0f ), material.shininess );
+	float distance = glm::length( light.position - fragPos );
+	float attenuation = 1.0f / ( light.constant + light.linear * distance + light.quadratic * ( distance * distance ) );
+	float theta = glm::dot( lightDir, glm::normalize( -light.direction ) );
+	float epsilon = light.cutOff - light.outerCutOff;
+	float intensity = glm::clamp( ( theta - light.outerCutOff ) / epsilon, 0.0f, 1.0f );
+
+	return ( light.ambient * texel + light.diffuse * diff * texel + light.specular * spec * material.specular ) * attenuation * intensity;
+}
+
+inline uint8_t ToByte( float value ){
+	return ( uint8_t ) ( glm::clamp( value, 0.0f, 1.0f ) * 255.0f + 0.5f );
+}
+
+}
+
+SoftwareRasterizer::SoftwareRasterizer( int width, int height, int tileSize, unsigned int threads )
+	: m_Width( width ), m_Height( height ), m_TileSize( tileSize ),
+	m_Threads( threads ? threads : HardwareThreads() ){
+	m_TilesX = ( width + tileSize - 1 ) / tileSize;
+	m_TilesY = ( height + tileSize - 1 ) / tileSize;
+	m_Color.resize( ( size_t ) width * height * 4 );
+	m_Depth.resize( ( size_t ) width * height );
+
+	for( const RasterTexture *&texture : m_Textures )
+		texture = nullptr;
+
+	Clear();
+}
+
+void SoftwareRasterizer::Clear( glm::vec4 color ){
+	uint8_t rgba[ 4 ] = { ToByte( color.r ), ToByte( color.g ), ToByte( color.b ), ToByte( color.a ) };
+	for( size_t i = 0; i < m_Depth.size(); i++ ){
+		std::copy( rgba, rgba + 4, &m_Color[ i * 4 ] );
+		m_Depth[ i ] = 1.0f;
+	}
+}
+
+void SoftwareRasterizer::SetTexture( int slot, const RasterTexture *texture ){
+	if( slot >= 0 && slot < 3 )
+		m_Textures[ slot ] = texture;
+}
+
+void SoftwareRasterizer::Draw( const VertexStream &stream, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, const SceneLights &lights, const ExplodeParams &explode ){
+	const size_t vertexCount = stream.vertexCount - stream.vertexCount % 3;
+	const size_t triangleCount = vertexCount / 3;
+	const glm::mat4 viewProjection = projection * view;
+	// Normals go to world space like fragPos, as in project.shader, the inverse transpose keeps them normal under a non uniform scale
+	const glm::mat3 normalMatrix = glm::transpose( glm::inverse( glm::mat3( model ) ) );
+
+	// Vertex stage
+	std::vector<ShadedVertex> vertices( vertexCount );
+	ParallelFor( vertexCount, m_Threads, [ & ]( size_t begin, size_t end, unsigned int ){
+		for( size_t i = begin; i < end; i++ ){
+			const float *in = stream.data + i * stream.stride;
+			ShadedVertex &out = vertices[ i ];
+
+			glm::vec3 position( in[ stream.position ], in[ stream.position + 1 ], in[ stream.position + 2 ] );
+			out.fragPos = glm::vec3( model * glm::vec4( position, 1.0f ) );
+			out.texCoord = glm::vec2( in[ stream.texCoord ], in[ stream.texCoord + 1 ] );
+			out.texIndex = in[ stream.texIndex ];
+			out.normal = glm::normalize( normalMatrix * glm::vec3( in[ stream.normal ], in[ stream.normal + 1 ], in[ stream.normal + 2 ] ) );
+
+			out.clip = viewProjection * glm::vec4( out.fragPos, 1.0f );
+		}
+	} );
+
+	// Triangle setup and binning, one set of bins per chunk so no worker waits on another
+	unsigned int chunks = ParallelChunks( triangleCount, m_Threads );
+	std::vector<Bins> bins( chunks );
+	const int tileCount = m_TilesX * m_TilesY;
+
+	ParallelFor( triangleCount, chunks, [ & ]( size_t begin, size_t end, unsigned int chunk ){
+		Bins &local = bins[ chunk ];
+		local.tiles.resize( tileCount );
+
+		// Setup of a triangle in front of the near plane, binned into every tile its bounds touch
+		auto bin = [ & ]( const uint32_t v[ 3 ], const glm::vec4 clip[ 3 ] ){
+			TriangleSetup setup;
+			// Only a projection without a near plane in front of the eye gets here with w <= 0
+			if( clip[ 0 ].w <= 1e-6f || clip[ 1 ].w <= 1e-6f || clip[ 2 ].w <= 1e-6f )
+				return;
+			std::copy( v, v + 3, setup.v );
+
+			glm::vec2 window[ 3 ];
+			for( int k = 0; k < 3; k++ ){
+				setup.invW[ k ] = 1.0f / clip[ k ].w;
+				glm::vec3 ndc = glm::vec3( clip[ k ] ) * setup.invW[ k ];
+				window[ k ] = glm::vec2( ( ndc.x * 0.5f + 0.5f ) * m_Width, ( 0.5f - ndc.y * 0.5f ) * m_Height );
+				setup.z[ k ] = ndc.z * 0.5f + 0.5f;
+			}
+
+			glm::vec2 p0 = window[ 0 ], p1 = window[ 1 ], p2 = window[ 2 ];
+			float area = ( p1.x - p0.x ) * ( p2.y - p0.y ) - ( p1.y - p0.y ) * ( p2.x - p0.x );
+			if( area == 0.0f )
+				return;
+
+			// Both windings are drawn, like the application without face culling
+			if( area < 0.0f ){
+				std::swap( setup.v[ 1 ], setup.v[ 2 ] );
+				std::swap( setup.z[ 1 ], setup.z[ 2 ] );
+				std::swap( setup.invW[ 1 ], setup.invW[ 2 ] );
+				std::swap( p1, p2 );
+				area = -area;
+			}
+
+			const glm::vec2 *corners[ 3 ] = { &p0, &p1, &p2 };
+			for( int e = 0; e < 3; e++ ){
+				const glm::vec2 &a = *corners[ ( e + 1 ) % 3 ];
+				const glm::vec2 &b = *corners[ ( e + 2 ) % 3 ];
+				setup.A[ e ] = a.y - b.y;
+				setup.B[ e ] = b.x - a.x;
+				setup.C[ e ] = -( setup.A[ e ] * a.x + setup.B[ e ] * a.y );
+				// Shared edges are owned by exactly one of the two triangles
+				setup.topLeft[ e ] = setup.A[ e ] > 0.0f || ( setup.A[ e ] == 0.0f && setup.B[ e ] < 0.0f );
+			}
+			setup.invArea = 1.0f / area;
+
+			setup.minX = std::max( 0, ( int ) floorf( std::min( { p0.x, p1.x, p2.x } ) ) );
+			setup.minY = std::max( 0, ( int ) floorf( std::min( { p0.y, p1.y, p2.y } ) ) );
+			setup.maxX = std::min( m_Width - 1, ( int ) ceilf( std::max( { p0.x, p1.x, p2.x } ) ) );
+			setup.maxY = std::min( m_Height - 1, ( int ) ceilf( std::max( { p0.y, p1.y, p2.y } ) ) );
+			if( setup.minX > setup.maxX || setup.minY > setup.maxY )
+				return;
+
+			uint32_t index = ( uint32_t ) local.setups.size();
+			local.setups.push_back( setup );
+
+			for( int ty = setup.minY / m_TileSize; ty <= setup.maxY / m_TileSize; ty++ )
+				for( int tx = setup.minX / m_TileSize; tx <= setup.maxX / m_TileSize; tx++ )
+					local.tiles[ ty * m_TilesX + tx ].push_back( index );
+		};
+
+		for( size_t t = begin; t < end; t++ ){
+			uint32_t v[ 3 ] = { ( uint32_t ) ( t * 3 ), ( uint32_t ) ( t * 3 + 1 ), ( uint32_t ) ( t * 3 + 2 ) };
+			glm::vec4 clip[ 3 ] = { vertices[ v[ 0 ] ].clip, vertices[ v[ 1 ] ].clip, vertices[ v[ 2 ] ].clip };
+
+			// Geometry stage, moves the triangle along its clip space normal like explode() in project.shader
+			if( explode.time != 0.0f ){
+				glm::vec3 normal = glm::normalize( glm::vec3( clip[ 0 ] - clip[ 1 ] ) + glm::vec3( clip[ 2 ] - clip[ 1 ] ) );
+				glm::vec4 direction( normal * ( ( sinf( explode.time ) + 1.0f ) / 2.0f ) * explode.magnitude, 0.0f );
+				for( glm::vec4 &corner : clip )
+					corner += direction;
+			}
+
+			// Signed distances to the near plane z = -w of GL, which is w = near for a perspective projection
+			float distance[ 3 ];
+			int inside = 0;
+			for( int k = 0; k < 3; k++ ){
+				distance[ k ] = clip[ k ].z + clip[ k ].w;
+				inside += distance[ k ] >= 0.0f;
+			}
+
+			if( inside == 3 ){
+				bin( v, clip );
+				continue;
+			}
+			if( inside == 0 )
+				continue;
+
+			// Sutherland-Hodgman before the perspective divide: a corner behind the plane is replaced by
+			// where its edges cross it, one triangle becomes a triangle or a quad
+			uint32_t polygon[ 4 ];
+			glm::vec4 polygonClip[ 4 ];
+			int count = 0;
+			for( int k = 0; k < 3; k++ ){
+				int next = ( k + 1 ) % 3;
+				if( distance[ k ] >= 0.0f ){
+					polygon[ count ] = v[ k ];
+					polygonClip[ count++ ] = clip[ k ];
+				}
+				if( ( distance[ k ] >= 0.0f ) != ( distance[ next ] >= 0.0f ) ){
+					float s = distance[ k ] / ( distance[ k ] - distance[ next ] );
+					ShadedVertex crossing = Mix( vertices[ v[ k ] ], vertices[ v[ next ] ], s );
+					crossing.clip = glm::mix( clip[ k ], clip[ next ], s );
+					polygon[ count ] = CLIPPED_VERTEX | ( uint32_t ) local.clipped.size();
+					polygonClip[ count++ ] = crossing.clip;
+					local.clipped.push_back( crossing );
+				}
+			}
+
+			for( int k = 1; k + 1 < count; k++ ){
+				uint32_t fanV[ 3 ] = { polygon[ 0 ], polygon[ k ], polygon[ k + 1 ] };
+				glm::vec4 fanClip[ 3 ] = { polygonClip[ 0 ], polygonClip[ k ], polygonClip[ k + 1 ] };
+				bin( fanV, fanClip );
+			}
+		}
+	} );
+
+	// Fragment stage, workers take the next free tile until none is left
+	std::atomic<int> nextTile( 0 );
+	const Material &material = lights.material;
+
+	auto vertexOf = [ & ]( const Bins &local, uint32_t index ) -> const ShadedVertex &{
+		return index & CLIPPED_VERTEX ? local.clipped[ index & ~CLIPPED_VERTEX ] : vertices[ index ];
+	};
+
+	auto shade = [ & ]( const Bins &local, const TriangleSetup &setup, int x, int y, float e0, float e1, float e2 ){
+		const ShadedVertex &v0 = vertexOf( local, setup.v[ 0 ] );
+		const ShadedVertex &v1 = vertexOf( local, setup.v[ 1 ] );
+		const ShadedVertex &v2 = vertexOf( local, setup.v[ 2 ] );
+
+		float b0 = e0 * setup.invArea, b1 = e1 * setup.invArea, b2 = e2 * setup.invArea;
+		float depth = b0 * setup.z[ 0 ] + b1 * setup.z[ 1 ] + b2 * setup.z[ 2 ];
+		// Outside the near and far planes
+		if( depth < 0.0f || depth > 1.0f )
+			return;
+
+		size_t pixel = ( size_t ) y * m_Width + x;
+		if( !( depth < m_Depth[ pixel ] ) )
+			return;
+
+		// Perspective correct weights
+		float w0 = b0 * setup.invW[ 0 ], w1 = b1 * setup.invW[ 1 ], w2 = b2 * setup.invW[ 2 ];
+		float inverse = 1.0f / ( w0 + w1 + w2 );
+		w0 *= inverse;
+		w1 *= inverse;
+		w2 *= inverse;
+
+		glm::vec3 fragPos = v0.fragPos * w0 + v1.fragPos * w1 + v2.fragPos * w2;
+		glm::vec2 texCoord = v0.texCoord * w0 + v1.texCoord * w1 + v2.texCoord * w2;
+		glm::vec3 normal = glm::normalize( v0.normal * w0 + v1.normal * w1 + v2.normal * w2 );
+		int index = ( int ) ( v0.texIndex * w0 + v1.texIndex * w1 + v2.texIndex * w2 );
+
+		const RasterTexture *texture = index >= 0 && index < 3 ? m_Textures[ index ] : nullptr;
+		glm::vec3 texel = texture ? texture->Sample( texCoord ) : glm::vec3( 0.0f );
+
+		glm::vec3 viewDir = glm::normalize( lights.viewPos - fragPos );
+		glm::vec3 result = CalcDirLight( lights.dirLight, material, texel, normal, viewDir );
+		for( int i = 0; i < NR_POINT_LIGHTS; i++ )
+			result += CalcPointLight( lights.pointLights[ i ], material, texel, normal, fragPos, viewDir );
+		result += CalcSpotLight( lights.spotLight, material, texel, normal, fragPos, viewDir );
+
+		m_Depth[ pixel ] = depth;
+		uint8_t *out = &m_Color[ pixel * 4 ];
+		out[ 0 ] = ToByte( result.r );
+		out[ 1 ] = ToByte( result.g );
+		out[ 2 ] = ToByte( result.b );
+		out[ 3 ] = 255;
+	};
+
+	ParallelFor( m_Threads, m_Threads, [ & ]( size_t, size_t, unsigned int ){
+		for( int tile = nextTile++; tile < tileCount; tile = nextTile++ ){
+			int tileX0 = ( tile % m_TilesX ) * m_TileSize;
+			int tileY0 = ( tile / m_TilesX ) * m_TileSize;
+			int tileX1 = std::min( tileX0 + m_TileSize, m_Width ) - 1;
+			int tileY1 = std::min( tileY0 + m_TileSize, m_Height ) - 1;
+
+			for( const Bins &local : bins ){
+				for( uint32_t index : local.tiles[ tile ] ){
+					const TriangleSetup &setup = local.setups[ index ];
+					int x0 = std::max( setup.minX, tileX0 ), x1 = std::min( setup.maxX, tileX1 );
+					int y0 = std::max( setup.minY, tileY0 ), y1 = std::min( setup.maxY, tileY1 );
+
+					for( int y = y0; y <= y1; y++ ){
+						float py = y + 0.5f;
+						int x = x0;
+
+#ifdef RASTERIZER_SSE
+						// Four pixels of the row per step
+						__m128 offsets = _mm_setr_ps( 0.5f, 1.5f, 2.5f, 3.5f );
+						__m128 edgeA[ 3 ], edgeRow[ 3 ];
+						bool strict[ 3 ];
+						for( int e = 0; e < 3; e++ ){
+							edgeA[ e ] = _mm_set1_ps( setup.A[ e ] );
+							edgeRow[ e ] = _mm_set1_ps( setup.B[ e ] * py + setup.C[ e ] );
+							strict[ e ] = !setup.topLeft[ e ];
+						}
+						const __m128 zero = _mm_setzero_ps();
+
+						for( ; x + 3 <= x1; x += 4 ){
+							__m128 px = _mm_add_ps( _mm_set1_ps( ( float ) x ), offsets );
+							__m128 e[ 3 ];
+							__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+							for( int k = 0; k < 3; k++ ){
+								e[ k ] = _mm_add_ps( _mm_mul_ps( edgeA[ k ], px ), edgeRow[ k ] );
+								inside = _mm_and_ps( inside, strict[ k ] ? _mm_cmpgt_ps( e[ k ], zero ) : _mm_cmpge_ps( e[ k ], zero ) );
+							}
+
+							int mask = _mm_movemask_ps( inside );
+							if( !mask )
+								continue;
+
+							alignas( 16 ) float e0[ 4 ], e1[ 4 ], e2[ 4 ];
+							_mm_store_ps( e0, e[ 0 ] );
+							_mm_store_ps( e1, e[ 1 ] );
+							_mm_store_ps( e2, e[ 2 ] );
+							for( int lane = 0; lane < 4; lane++ )
+								if( mask & ( 1 << lane ) )
+									shade( local, setup, x + lane, y, e0[ lane ], e1[ lane ], e2[ lane ] );
+						}
+#endif
+
+						for( ; x <= x1; x++ ){
+							float px = x + 0.5f;
+							float e[ 3 ];
+							bool inside = true;
+							for( int k = 0; k < 3; k++ ){
+								e[ k ] = setup.A[ k ] * px + setup.B[ k ] * py + setup.C[ k ];
+								inside = inside && ( setup.topLeft[ k ] ? e[ k ] >= 0.0f : e[ k ] > 0.0f );
+							}
+
+							if( inside )
+								shade( local, setup, x, y, e[ 0 ], e[ 1 ], e[ 2 ] );
+						}
+					}
+				}
+			}
+		}
+	} );
+}
+
+bool SoftwareRasterizer::Write( const std::string &path ) const{
+	return ImageWriter::Write( path, m_Color.data(), m_Width, m_Height );
+}
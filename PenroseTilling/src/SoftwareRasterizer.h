@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Lights.h"
+
+// Interleaved float vertices, by default in the layout of GetVerticesWithColorsTexCoordsAndNormalLight
+struct VertexStream{
+	const float *data;
+	size_t vertexCount;
+	// Floats from one vertex to the next and offsets of each attribute inside a vertex
+	size_t stride = 12;
+	size_t position = 0;
+	size_t color = 3;
+	size_t texCoord = 6;
+	size_t texIndex = 8;
+	size_t normal = 9;
+};
+
+// The time and magnitude uniforms of the geometry stage in project.shader, time 0 leaves triangles in place
+struct ExplodeParams{
+	float time = 0.0f;
+	float magnitude = 0.0f;
+};
+
+// RGBA8 image sampled with GL_LINEAR and GL_CLAMP_TO_EDGE, first row is v = 0 like the flipped textures of Texture
+struct RasterTexture{
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels;
+
+	// @return false when the file can't be decoded
+	bool Load( const std::string &path );
+	glm::vec3 Sample( glm::vec2 uv ) const;
+};
+
+/**
+ * Tile based software renderer for the tilling, with the same vertex and fragment stages as project.shader.
+ * Triangles are binned into screen tiles and every tile is shaded by one worker thread with SSE edge functions.
+ */
+class SoftwareRasterizer{
+private:
+	int m_Width;
+	int m_Height;
+	int m_TileSize;
+	int m_TilesX;
+	int m_TilesY;
+	unsigned int m_Threads;
+
+	// RGBA8, first row is the top of the image
+	std::vector<uint8_t> m_Color;
+	// Window depth in [0, 1], 1 is the far plane
+	std::vector<float> m_Depth;
+
+	// Texture per sampler slot, like the units bound with glBindTextureUnit
+	const RasterTexture *m_Textures[ 3 ];
+
+public:
+	/**
+	 * @param width, height: Size of the frame in pixels
+	 * @param tileSize: Side of the square screen tiles each worker shades
+	 * @param threads: Number of workers, 0 for one per hardware thread
+	 */
+	SoftwareRasterizer( int width, int height, int tileSize = 64, unsigned int threads = 0 );
+
+	void Clear( glm::vec4 color = glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f ) );
+
+	// Texture sampled by the fragments with texture index slot, nullptr samples black like an unbound unit
+	void SetTexture( int slot, const RasterTexture *texture );
+
+	// Draw every 3 vertices of the stream as a triangle with GL_LESS depth testing
+	void Draw( const VertexStream &stream, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, const SceneLights &lights, const ExplodeParams &explode = ExplodeParams() );
+
+	inline int GetWidth() const{ return m_Width; }
+	inline int GetHeight() const{ return m_Height; }
+	inline const std::vector<uint8_t> &GetColor() const{ return m_Color; }
+	inline const std::vector<float> &GetDepth() const{ return m_Depth; }
+
+	// PNG, or PPM when path ends with .ppm. @return false if the file can't be written
+	bool Write( const std::string &path ) const;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+
+// View over contiguous memory owned by someone else, std::span needs C++20
+template<typename T>
+class Span{
+private:
+	T *m_Data;
+	size_t m_Size;
+
+public:
+	Span()
+		: m_Data( nullptr ), m_Size( 0 ){ }
+
+	Span( T *data, size_t size )
+		: m_Data( data ), m_Size( size ){ }
+
+	inline T *data() const{ return m_Data; }
+	inline size_t size() const{ return m_Size; }
+	inline bool empty() const{ return m_Size == 0; }
+
+	inline T *begin() const{ return m_Data; }
+	inline T *end() const{ return m_Data + m_Size; }
+	inline T &operator[]( size_t index ) const{ return m_Data[ index ]; }
+
+	// @return count elements from offset, cut at the end of the span
+	Span subspan( size_t offset, size_t count ) const{
+		if( offset > m_Size )
+			offset = m_Size;
+		return Span( m_Data + offset, count < m_Size - offset ? count : m_Size - offset );
+	}
+};
@@ -0,0 +1,117 @@
+#include "SubstitutionDag.h"
+
+#include "Profiler.h"
+
+namespace{
+
+// TriangleT::GetInstance without going through float
+SubstitutionDag::Placement PlacementOf( const TriangleT<double> &t ){
+	glm::dvec3 u = t.b.ToDVec3() - t.a.ToDVec3();
+	glm::dvec3 v = t.c.ToDVec3() - t.a.ToDVec3();
+	double scale = sqrt( u.x * u.x + u.y * u.y );
+	bool mirrored = u.x * v.y - u.y * v.x < 0.0;
+	return { t.a.x, t.a.y, atan2( u.y, u.x ), mirrored ? -scale : scale };
+}
+
+TileInstance ToInstance( const SubstitutionDag::Placement &placement ){
+	return { ( float ) placement.x, ( float ) placement.y, ( float ) placement.rotation, ( float ) placement.scale };
+}
+
+}
+
+SubstitutionDag::SubstitutionDag( int levels, CoordinateT<double> origin, int degree, float height )
+	: m_Depth( levels ){
+	PROFILE_SCOPE( "SubstitutionDag::SubstitutionDag" );
+
+	// The children of a type come from deflating its prototype once, with the same code as the tilling
+	std::vector<Child> rules[ 2 ];
+	for( int type = 1; type <= 2; type++ ){
+		PenroseT<double> prototype( TriangleT<double>::Prototype( type ), 1 );
+		prototype.execute();
+		for( const TriangleT<double> &t : prototype.GetTriangles() )
+			rules[ type - 1 ].push_back( { t.type, PlacementOf( t ) } );
+	}
+
+	m_Nodes.resize( ( levels + 1 ) * 2 );
+	for( int depth = 0; depth <= levels; depth++ ){
+		for( int type = 1; type <= 2; type++ ){
+			Node &node = m_Nodes[ depth * 2 + type - 1 ];
+			node.type = type;
+			node.depth = depth;
+			node.tiles = 1;
+			if( depth > 0 ){
+				node.children = rules[ type - 1 ];
+				node.tiles = 0;
+				for( const Child &child : node.children )
+					node.tiles += GetNode( child.type, depth - 1 ).tiles;
+			}
+		}
+	}
+
+	PenroseT<double> seeds( 0, origin, degree, height );
+	for( const TriangleT<double> &t : seeds.GetTriangles() )
+		m_Seeds.push_back( { t.type, PlacementOf( t ) } );
+}
+
+SubstitutionDag::Placement SubstitutionDag::Compose( const Placement &parent, const Placement &child ){
+	// The parent mirrors the frame of the child across its x axis before rotating it
+	double y = parent.scale < 0.0 ? -child.y : child.y;
+	double rotation = parent.scale < 0.0 ? -child.rotation : child.rotation;
+	double scale = fabs( parent.scale );
+	double c = cos( parent.rotation );
+	double s = sin( parent.rotation );
+
+	return {
+		parent.x + scale * ( c * child.x - s * y ),
+		parent.y + scale * ( s * child.x + c * y ),
+		parent.rotation + rotation,
+		parent.scale * child.scale
+	};
+}
+
+const SubstitutionDag::Node &SubstitutionDag::GetNode( int type, int depth ) const{
+	return m_Nodes[ depth * 2 + type - 1 ];
+}
+
+uint64_t SubstitutionDag::GetNumInstances( int type, int depth ) const{
+	// Nodes of each type at every depth from the top, the DAG is never expanded
+	uint64_t counts[ 2 ] = { 0, 0 };
+	for( const Child &seed : m_Seeds )
+		counts[ seed.type - 1 ]++;
+
+	for( int d = m_Depth; d > depth; d-- ){
+		uint64_t next[ 2 ] = { 0, 0 };
+		for( int t = 1; t <= 2; t++ )
+			for( const Child &child : GetNode( t, d ).children )
+				next[ child.type - 1 ] += counts[ t - 1 ];
+		counts[ 0 ] = next[ 0 ];
+		counts[ 1 ] = next[ 1 ];
+	}
+	return counts[ type - 1 ];
+}
+
+uint64_t SubstitutionDag::GetNumTiles() const{
+	uint64_t tiles = 0;
+	for( const Child &seed : m_Seeds )
+		tiles += GetNode( seed.type, m_Depth ).tiles;
+	return tiles;
+}
+
+size_t SubstitutionDag::ExpandInstances( int type, int depth, Span<TileInstance> out ) const{
+	PROFILE_SCOPE( "SubstitutionDag::ExpandInstances" );
+	size_t count = 0;
+	for( const Child &seed : m_Seeds )
+		Expand( seed, m_Depth, type, depth, out, count );
+	return count;
+}
+
+void SubstitutionDag::Expand( const Child &node, int depth, int type, int targetDepth, Span<TileInstance> out, size_t &count ) const{
+	if( depth == targetDepth ){
+		if( node.type == type && count < out.size() )
+			out[ count++ ] = ToInstance( node.placement );
+		return;
+	}
+
+	for( const Child &child : GetNode( node.type, depth ).children )
+		Expand( { child.type, Compose( node.placement, child.placement ) }, depth - 1, type, targetDepth, out, count );
+}
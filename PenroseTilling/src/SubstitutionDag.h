@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Penrose.h"
+#include "Span.h"
+
+/*
+ * The tilling as a DAG of supertiles. A node is the tile of a type deflated depth times, and its children
+ * are the nodes one depth down it splits into, each placed by a similarity in the frame of the prototype
+ * of the parent ( TriangleT::Prototype ). Deflating works the same at every scale, so a depth has only two
+ * distinct nodes and a tilling of n levels takes 2 ( n + 1 ) nodes and its seeds, whatever its size.
+ *
+ * It's drawn by expanding the top levels into instances of the supertiles of some depth and drawing the
+ * mesh of those two nodes, deflated once and cached, for each of them ( InstancedTilling ).
+ */
+class SubstitutionDag{
+public:
+	// Similarity in the frame of a prototype, same fields as TileInstance in double so levels compose exactly
+	struct Placement{
+		double x;
+		double y;
+		double rotation;
+		double scale;
+	};
+
+	struct Child{
+		int type;
+		Placement placement;
+	};
+
+	struct Node{
+		// 1 or 2 like TriangleT::type
+		int type;
+		int depth;
+		// Nodes of depth - 1, none at depth 0 where the node is a single tile
+		std::vector<Child> children;
+		// Tiles of the node once expanded to depth 0
+		uint64_t tiles;
+	};
+
+private:
+	// m_Nodes[ depth * 2 + type - 1 ]
+	std::vector<Node> m_Nodes;
+	// Top level nodes, at depth m_Depth
+	std::vector<Child> m_Seeds;
+	int m_Depth;
+
+	void Expand( const Child &node, int depth, int type, int targetDepth, Span<TileInstance> out, size_t &count ) const;
+
+public:
+	// Same parameters as the PenroseT constructor, the seeds are its triangles and levels its loops
+	SubstitutionDag( int levels, CoordinateT<double> origin, int degree, float height );
+
+	// @return where child is in the tilling when parent is where the node holding it is
+	static Placement Compose( const Placement &parent, const Placement &child );
+
+	const Node &GetNode( int type, int depth ) const;
+	inline int GetDepth() const{ return m_Depth; }
+	inline size_t GetNumNodes() const{ return m_Nodes.size(); }
+	inline const std::vector<Child> &GetSeeds() const{ return m_Seeds; }
+
+	// @return the nodes of the type and depth the tilling expands to, what ExpandInstances writes
+	uint64_t GetNumInstances( int type, int depth ) const;
+	// @return the tiles of the whole tilling without expanding it
+	uint64_t GetNumTiles() const;
+
+	/**
+	 * Expand the levels above depth into the placements of its nodes of the type, to draw the mesh of
+	 * GetNode( type, depth ) at each one. Depth 0 gives the TileInstance of every tile
+	 *
+	 * @param out: GetNumInstances( type, depth ) instances
+	 * @return the instances written
+	 */
+	size_t ExpandInstances( int type, int depth, Span<TileInstance> out ) const;
+};
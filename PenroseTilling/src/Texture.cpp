@@ -1,12 +1,16 @@
 #include "Texture.h"
 #include <iostream>
 #include "stb_image/stb_image.h"
+#include "Profiler.h"
 
 Texture::Texture( const std::string &path )
 	: m_FilePath(path), m_LocalBuffer(nullptr),
 	m_Width(0), m_Height(0), m_BPP(0){
-	stbi_set_flip_vertically_on_load( 1 );
-	m_LocalBuffer = stbi_load( path.c_str(), &m_Width, &m_Height, &m_BPP, 4 );
+	{
+		PROFILE_SCOPE( "Texture::Decode" );
+		stbi_set_flip_vertically_on_load( 1 );
+		m_LocalBuffer = stbi_load( path.c_str(), &m_Width, &m_Height, &m_BPP, 4 );
+	}
 
 	GLCall( glCreateTextures( GL_TEXTURE_2D, 1, &m_RendererID ) );
 	GLCall( glBindTexture( GL_TEXTURE_2D, m_RendererID ) );
@@ -17,12 +21,14 @@ Texture::Texture( const std::string &path )
 	GLCall( glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE ) );
 
 	if( m_LocalBuffer ){
+		PROFILE_SCOPE( "Texture::Upload" );
 		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer );
+		RenderStats::AddUploadedBytes( ( unsigned long long ) m_Width * m_Height * 4 );
 		stbi_image_free( m_LocalBuffer );
 	} else{
 		std::cout << "\nError: Failed to load texture" << std::endl;
 		std::cout << stbi_failure_reason() << std::endl;
-		__debugbreak();
+		DEBUG_BREAK();
 	}
 
 }
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "Lights.h"
+
+/*
+ * The uniform blocks of project.shader laid out by std140: a vec3 takes 16 bytes unless a float follows
+ * it, structs and array elements start at multiples of 16. The GLSL structs put a float after every vec3
+ * they can, the rest is padding here. Each block has the name it has in the shader and a binding point.
+ */
+
+struct CameraBlock{
+	static const unsigned int BINDING = 0;
+	static constexpr const char *NAME = "CameraBlock";
+
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::mat4 model;
+	glm::vec3 viewPos;
+	float pad0;
+
+	static CameraBlock From( const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model, glm::vec3 viewPos ){
+		CameraBlock block = CameraBlock();
+		block.projection = projection;
+		block.view = view;
+		block.model = model;
+		block.viewPos = viewPos;
+		return block;
+	}
+};
+
+struct DirLightStd140{
+	glm::vec3 direction;
+	float pad0;
+	glm::vec3 ambient;
+	float pad1;
+	glm::vec3 diffuse;
+	float pad2;
+	glm::vec3 specular;
+	float pad3;
+};
+
+struct PointLightStd140{
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	float pad0;
+};
+
+struct SpotLightStd140{
+	glm::vec3 position;
+	float cutOff;
+	glm::vec3 direction;
+	float outerCutOff;
+	glm::vec3 ambient;
+	float constant;
+	glm::vec3 diffuse;
+	float linear;
+	glm::vec3 specular;
+	float quadratic;
+};
+
+struct LightsBlock{
+	static const unsigned int BINDING = 1;
+	static constexpr const char *NAME = "LightsBlock";
+
+	DirLightStd140 dirLight;
+	PointLightStd140 pointLights[ NR_POINT_LIGHTS ];
+	SpotLightStd140 spotLight;
+
+	// SceneLights::viewPos goes in the CameraBlock and its material in the MaterialBlock
+	static LightsBlock From( const SceneLights &lights ){
+		LightsBlock block = LightsBlock();
+
+		block.dirLight.direction = lights.dirLight.direction;
+		block.dirLight.ambient = lights.dirLight.ambient;
+		block.dirLight.diffuse = lights.dirLight.diffuse;
+		block.dirLight.specular = lights.dirLight.specular;
+
+		for( int i = 0; i < NR_POINT_LIGHTS; i++ ){
+			const PointLight &light = lights.pointLights[ i ];
+			PointLightStd140 &out = block.pointLights[ i ];
+			out.position = light.position;
+			out.constant = light.constant;
+			out.ambient = light.ambient;
+			out.linear = light.linear;
+			out.diffuse = light.diffuse;
+			out.quadratic = light.quadratic;
+			out.specular = light.specular;
+		}
+
+		const SpotLight &spot = lights.spotLight;
+		block.spotLight.position = spot.position;
+		block.spotLight.cutOff = spot.cutOff;
+		block.spotLight.direction = spot.direction;
+		block.spotLight.outerCutOff = spot.outerCutOff;
+		block.spotLight.ambient = spot.ambient;
+		block.spotLight.constant = spot.constant;
+		block.spotLight.diffuse = spot.diffuse;
+		block.spotLight.linear = spot.linear;
+		block.spotLight.specular = spot.specular;
+		block.spotLight.quadratic = spot.quadratic;
+
+		return block;
+	}
+};
+
+struct MaterialBlock{
+	static const unsigned int BINDING = 2;
+	static constexpr const char *NAME = "MaterialBlock";
+
+	// The diffuse textures are samplers, which can't be in a block
+	glm::vec3 specular;
+	float shininess;
+
+	static MaterialBlock From( const Material &material ){
+		MaterialBlock block = MaterialBlock();
+		block.specular = material.specular;
+		block.shininess = material.shininess;
+		return block;
+	}
+};
+
+// Offsets std140 gives the members in the shader
+static_assert( sizeof( glm::vec3 ) == 12 && sizeof( glm::mat4 ) == 64, "std140 blocks need tightly packed glm types" );
+static_assert( offsetof( CameraBlock, viewPos ) == 192 && sizeof( CameraBlock ) == 208, "CameraBlock doesn't match std140" );
+static_assert( sizeof( DirLightStd140 ) == 64 && sizeof( PointLightStd140 ) == 64 && sizeof( SpotLightStd140 ) == 80, "Light structs don't match std140" );
+static_assert( offsetof( LightsBlock, pointLights ) == 64 && offsetof( LightsBlock, spotLight ) == 320, "LightsBlock doesn't match std140" );
+static_assert( sizeof( MaterialBlock ) == 16, "MaterialBlock doesn't match std140" );
@@ -0,0 +1,26 @@
+#include "UniformBuffer.h"
+
+#include "Renderer.h"
+
+UniformBuffer::UniformBuffer( unsigned int size, unsigned int binding )
+	: m_RendererID( 0 ), m_Size( size ), m_Binding( binding ){
+	GLCall( glGenBuffers( 1, &m_RendererID ) );
+	GLCall( glBindBuffer( GL_UNIFORM_BUFFER, m_RendererID ) );
+	GLCall( glBufferData( GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW ) );
+	Bind();
+}
+
+UniformBuffer::~UniformBuffer(){
+	GLCall( glDeleteBuffers( 1, &m_RendererID ) );
+}
+
+void UniformBuffer::SetData( const void *data, unsigned int size ){
+	ASSERT( size <= m_Size );
+	GLCall( glBindBuffer( GL_UNIFORM_BUFFER, m_RendererID ) );
+	GLCall( glBufferSubData( GL_UNIFORM_BUFFER, 0, size, data ) );
+	RenderStats::AddUploadedBytes( size );
+}
+
+void UniformBuffer::Bind() const{
+	GLCall( glBindBufferBase( GL_UNIFORM_BUFFER, m_Binding, m_RendererID ) );
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstring>
+
+class UniformBuffer{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+	unsigned int m_Binding;
+
+public:
+	/**
+	 * Storage for a uniform block of size bytes, bound to its binding point for good. The programs
+	 * reading it point their block at the same index with Shader::SetUniformBlockBinding
+	 */
+	UniformBuffer( unsigned int size, unsigned int binding );
+	~UniformBuffer();
+
+	UniformBuffer( const UniformBuffer & ) = delete;
+	UniformBuffer &operator=( const UniformBuffer & ) = delete;
+
+	// Overwrite the first size bytes
+	void SetData( const void *data, unsigned int size );
+
+	// Bind to the binding point again, after something else took it
+	void Bind() const;
+
+	inline unsigned int GetSize() const{ return m_Size; }
+	inline unsigned int GetBinding() const{ return m_Binding; }
+};
+
+/*
+ * A uniform block of UniformBlocks.h and the copy of its contents on the host. Set only marks it dirty
+ * when the contents change, so Upload sends nothing in the frames where the block stays the same.
+ */
+template<typename Block>
+class UniformBlock{
+private:
+	UniformBuffer m_Buffer;
+	Block m_Data;
+	bool m_Dirty;
+
+public:
+	UniformBlock()
+		: m_Buffer( sizeof( Block ), Block::BINDING ), m_Data(), m_Dirty( true ){ }
+
+	void Set( const Block &data ){
+		// The blocks have their padding as members, so the whole struct can be compared
+		if( std::memcmp( &m_Data, &data, sizeof( Block ) ) != 0 ){
+			m_Data = data;
+			m_Dirty = true;
+		}
+	}
+
+	// @return whether the block was dirty and sent to GL
+	bool Upload(){
+		if( !m_Dirty )
+			return false;
+		m_Buffer.SetData( &m_Data, sizeof( Block ) );
+		m_Dirty = false;
+		return true;
+	}
+
+	inline const Block &Get() const{ return m_Data; }
+	inline const UniformBuffer &GetBuffer() const{ return m_Buffer; }
+};
@@ -11,7 +11,7 @@ VertexArray::~VertexArray(){
 	GLCall( glDeleteVertexArrays( 1, &m_RendererID ) );
 }
 
-void VertexArray::AddBuffer( const VertexBuffer &vb, const VertexBufferLayout &layout ){
+void VertexArray::AddBuffer( const VertexBuffer &vb, const VertexBufferLayout &layout, unsigned int firstLocation, unsigned int divisor ){
 
 	Bind();
 	vb.Bind();
@@ -20,10 +20,12 @@ void VertexArray::AddBuffer( const VertexBuffer &vb, const VertexBufferLayout &l
 	for( int i = 0; i < elements.size(); i++ ){
 
 		const auto &element = elements[ i ];
-		GLCall( glEnableVertexAttribArray( i ) );
-		GLCall( glVertexAttribPointer( i, element.count, element.type,
+		const unsigned int location = firstLocation + i;
+		GLCall( glEnableVertexAttribArray( location ) );
+		GLCall( glVertexAttribPointer( location, element.count, element.type,
 			element.normalized, layout.GetStride(), ( const void * ) offset ) );
-		offset += element.count * VertexBufferElement::GetSizeOfType( element.type );
+		GLCall( glVertexAttribDivisor( location, divisor ) );
+		offset += element.GetSize();
 
 	}
 
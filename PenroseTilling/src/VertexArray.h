@@ -12,7 +12,11 @@ public:
 	VertexArray();
 	~VertexArray();
 
-	void AddBuffer( const VertexBuffer &vb, const VertexBufferLayout &layout );
+	/**
+	 * @param firstLocation: Location of the first attribute of the layout, for a second buffer
+	 * @param divisor: 0 for per vertex attributes, 1 to advance once per instance
+	 */
+	void AddBuffer( const VertexBuffer &vb, const VertexBufferLayout &layout, unsigned int firstLocation = 0, unsigned int divisor = 0 );
 
 	void Bind() const;
 	void UnBind() const;
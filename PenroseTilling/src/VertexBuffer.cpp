@@ -1,18 +1,88 @@
 #include "VertexBuffer.h"
 #include "Renderer.h"
 
-VertexBuffer::VertexBuffer( const void *data, unsigned int size ){
+VertexBuffer::VertexBuffer( const void *data, unsigned int size, unsigned int usage )
+	: m_Size( size ), m_Capacity( size ), m_Usage( usage ), m_Mapping( nullptr ), m_Fence( nullptr ){
 
 	GLCall( glGenBuffers( 1, &m_RendererID ) );
 	GLCall( glBindBuffer( GL_ARRAY_BUFFER, m_RendererID ) );
-	GLCall( glBufferData( GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW ) );
+	GLCall( glBufferData( GL_ARRAY_BUFFER, size, data, usage ) );
+	RenderStats::AddUploadedBytes( size );
+
+}
+
+VertexBuffer::VertexBuffer( unsigned int size )
+	: m_Size( size ), m_Capacity( size ), m_Usage( GL_STREAM_DRAW ), m_Mapping( nullptr ), m_Fence( nullptr ){
+
+	// Coherent, the writes are seen by the draws issued after them without a flush
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	GLCall( glGenBuffers( 1, &m_RendererID ) );
+	GLCall( glBindBuffer( GL_ARRAY_BUFFER, m_RendererID ) );
+	GLCall( glBufferStorage( GL_ARRAY_BUFFER, size, nullptr, flags ) );
+	GLCall( m_Mapping = glMapBufferRange( GL_ARRAY_BUFFER, 0, size, flags ) );
 
 }
 
 VertexBuffer::~VertexBuffer(){
+	if( m_Fence ){
+		GLCall( glDeleteSync( m_Fence ) );
+	}
+	// Deleting the buffer unmaps it
 	GLCall( glDeleteBuffers( 1, &m_RendererID ) );
 }
 
+void VertexBuffer::SetData( const void *data, unsigned int size ){
+	ASSERT( !m_Mapping );
+	if( size > m_Capacity )
+		m_Capacity = size + size / 2;
+
+	Bind();
+	GLCall( glBufferData( GL_ARRAY_BUFFER, m_Capacity, nullptr, m_Usage ) );
+	GLCall( glBufferSubData( GL_ARRAY_BUFFER, 0, size, data ) );
+	RenderStats::AddUploadedBytes( size );
+	m_Size = size;
+}
+
+void VertexBuffer::SetSubData( unsigned int offset, const void *data, unsigned int size ){
+	ASSERT( !m_Mapping && offset + size <= m_Size );
+
+	Bind();
+	GLCall( glBufferSubData( GL_ARRAY_BUFFER, offset, size, data ) );
+	RenderStats::AddUploadedBytes( size );
+}
+
+void *VertexBuffer::MapRange( unsigned int offset, unsigned int size ){
+	ASSERT( !m_Mapping && offset + size <= m_Capacity );
+
+	Bind();
+	void *range;
+	GLCall( range = glMapBufferRange( GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT ) );
+	RenderStats::AddUploadedBytes( size );
+	return range;
+}
+
+void VertexBuffer::Unmap(){
+	Bind();
+	GLCall( glUnmapBuffer( GL_ARRAY_BUFFER ) );
+}
+
+void *VertexBuffer::Map(){
+	if( m_Fence )
+		GLWaitFence( m_Fence );
+	return m_Mapping;
+}
+
+void VertexBuffer::Fence(){
+	if( !m_Mapping )
+		return;
+
+	if( m_Fence ){
+		GLCall( glDeleteSync( m_Fence ) );
+	}
+	GLCall( m_Fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) );
+}
+
 void VertexBuffer::Bind() const{
 	GLCall( glBindBuffer( GL_ARRAY_BUFFER, m_RendererID ) );
 }
@@ -1,13 +1,56 @@
 #pragma once
 
+#include <GL/glew.h>
+
 class VertexBuffer{
 private:
 	unsigned int  m_RendererID;
+	// Bytes of data, and of storage which can be more after SetData grew it
+	unsigned int m_Size;
+	unsigned int m_Capacity;
+	unsigned int m_Usage;
+	// Persistent mapping of the storage, null for a buffer filled by glBufferData
+	void *m_Mapping;
+	// Set after the last draw reading the mapped storage, Map waits for it
+	GLsync m_Fence;
 
 public:
-	VertexBuffer( const void *data, unsigned int size );
+	// @param usage: GL_STATIC_DRAW, or GL_DYNAMIC_DRAW / GL_STREAM_DRAW for a buffer updated with SetData or MapRange
+	VertexBuffer( const void *data, unsigned int size, unsigned int usage = GL_STATIC_DRAW );
+	/**
+	 * Immutable storage ( glBufferStorage ) of size bytes, mapped once for the life of the buffer so the
+	 * vertices are written straight into memory the GPU reads, without a copy on the host
+	 */
+	explicit VertexBuffer( unsigned int size );
 	~VertexBuffer();
 
+	/**
+	 * Replace the data. The storage is orphaned first, glBufferData without data, so the draws still
+	 * reading the old one aren't waited for, and it grows to 1.5 times the size when the data doesn't fit.
+	 * The buffer keeps its name, vertex arrays pointing at it stay valid. Not for mapped buffers
+	 */
+	void SetData( const void *data, unsigned int size );
+	// Overwrite size bytes from offset, within GetSize
+	void SetSubData( unsigned int offset, const void *data, unsigned int size );
+	/**
+	 * @return size bytes from offset to write, their old contents discarded. Unmap before drawing,
+	 * not for buffers mapped persistently
+	 */
+	void *MapRange( unsigned int offset, unsigned int size );
+	void Unmap();
+
+	/**
+	 * @return the mapped storage, once the GPU is done with the draws before the last Fence, so it can
+	 * be written again. Null for a buffer that isn't mapped
+	 */
+	void *Map();
+	// Mark the draws issued so far as readers of the mapped storage
+	void Fence();
+
 	void Bind() const;
 	void UnBind() const;
-};
\ No newline at end of file
+
+	inline unsigned int GetSize() const{ return m_Size; }
+	inline unsigned int GetCapacity() const{ return m_Capacity; }
+	inline bool IsMapped() const{ return m_Mapping != nullptr; }
+};
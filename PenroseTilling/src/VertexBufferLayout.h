@@ -3,23 +3,39 @@
 #include <vector>
 #include <GL/glew.h>
 #include "Renderer.h"
+#include "VertexFormats.h"
 
 struct VertexBufferElement{
 	unsigned int type;
 	unsigned int count;
 	unsigned char normalized;
 
+	// Bytes of one component, of the whole attribute for the packed types
 	static unsigned int GetSizeOfType( unsigned int type ){
 
 		switch( type ){
 			case GL_FLOAT:			return 4;
+			case GL_HALF_FLOAT:		return 2;
 			case GL_UNSIGNED_INT:	return 4;
+			case GL_UNSIGNED_SHORT:	return 2;
 			case GL_UNSIGNED_BYTE:	return 1;
+			case GL_INT_2_10_10_10_REV:
+			case GL_UNSIGNED_INT_2_10_10_10_REV:
+				return 4;
 		}
 
 		ASSERT( false );
 		return 0;
 	}
+
+	static bool IsPackedType( unsigned int type ){
+		return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+	}
+
+	// @return bytes of the attribute in the vertex
+	inline unsigned int GetSize() const{
+		return IsPackedType( type ) ? GetSizeOfType( type ) : count * GetSizeOfType( type );
+	}
 };
 
 class VertexBufferLayout{
@@ -32,37 +48,39 @@ public:
 	VertexBufferLayout()
 		: m_Stride(0){ }
 
-	template<typename T>
-	void Push( unsigned int count ){
+	// The layout of a format of VertexFormats.h, attribute N at location N
+	template<typename Format>
+	static VertexBufferLayout FromFormat(){
 
-		static_assert( false );
+		VertexBufferLayout layout;
+		for( const VertexAttribute &attribute : Format::ATTRIBUTES )
+			layout.Push( attribute );
+		// Takes the padding at the end of the vertex
+		layout.m_Stride = VertexStride<Format>();
+		return layout;
 
 	}
 
-	template<>
-	void Push <float>( unsigned int count ){
+	void Push( const VertexAttribute &attribute ){
 
-		m_Elements.push_back( { GL_FLOAT, count, GL_FALSE } );
-		m_Stride += count * VertexBufferElement::GetSizeOfType( GL_FLOAT );
+		Push( ( unsigned int ) attribute.type, attribute.count, attribute.normalized );
 
 	}
 
-	template<>
-	void Push <unsigned int>( unsigned int count ){
+	/**
+	 * @param type: GL_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_INT, GL_UNSIGNED_SHORT, GL_UNSIGNED_BYTE or a packed
+	 * 2_10_10_10_REV type, which takes 4 components in 4 bytes
+	 * @param normalized: Integers are mapped to [0, 1] ( [-1, 1] when signed ), otherwise converted as they are
+	 */
+	void Push( unsigned int type, unsigned int count, bool normalized ){
 
-		m_Elements.push_back( { GL_UNSIGNED_INT, count, GL_FALSE } );
-		m_Stride += count * VertexBufferElement::GetSizeOfType( GL_UNSIGNED_INT );
-	}
-
-	template<>
-	void Push <unsigned char>( unsigned int count ){
-
-		m_Elements.push_back( { GL_UNSIGNED_BYTE, count, GL_TRUE } );
-		m_Stride += count * VertexBufferElement::GetSizeOfType( GL_UNSIGNED_BYTE );
+		ASSERT( !VertexBufferElement::IsPackedType( type ) || count == 4 );
+		m_Elements.push_back( { type, count, ( unsigned char ) ( normalized ? GL_TRUE : GL_FALSE ) } );
+		m_Stride += m_Elements.back().GetSize();
 
 	}
 
 	inline const std::vector<VertexBufferElement> GetElements() const{ return m_Elements; }
 	inline unsigned int GetStride() const{ return m_Stride; }
 
-};
\ No newline at end of file
+};
@@ -0,0 +1,32 @@
+#include "VertexBufferRing.h"
+
+#include "Renderer.h"
+
+VertexBufferRing::VertexBufferRing( unsigned int sectionSize )
+	: m_Buffer( sectionSize * SECTIONS ), m_SectionSize( sectionSize ), m_Current( SECTIONS - 1 ){
+	for( GLsync &fence : m_Fences )
+		fence = nullptr;
+}
+
+VertexBufferRing::~VertexBufferRing(){
+	for( GLsync &fence : m_Fences ){
+		if( fence ){
+			GLCall( glDeleteSync( fence ) );
+		}
+	}
+}
+
+void *VertexBufferRing::Begin(){
+	m_Current = ( m_Current + 1 ) % SECTIONS;
+	if( m_Fences[ m_Current ] )
+		GLWaitFence( m_Fences[ m_Current ] );
+	return static_cast< char * >( m_Buffer.Map() ) + GetOffset();
+}
+
+void VertexBufferRing::End(){
+	GLsync &fence = m_Fences[ m_Current ];
+	if( fence ){
+		GLCall( glDeleteSync( fence ) );
+	}
+	GLCall( fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) );
+}
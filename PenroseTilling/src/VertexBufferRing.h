@@ -0,0 +1,40 @@
+#pragma once
+
+#include "VertexBuffer.h"
+
+/*
+ * Mapped storage for data rewritten every frame, split in SECTIONS parts used in turn. While the CPU writes
+ * the part of this frame the GPU can still be drawing the previous frames from the others, and a fence per
+ * part makes the CPU wait only when it laps the GPU. Draws read the current part through its offset, or its
+ * first element as a base vertex or instance.
+ */
+class VertexBufferRing{
+public:
+	static const unsigned int SECTIONS = 3;
+
+private:
+	VertexBuffer m_Buffer;
+	unsigned int m_SectionSize;
+	unsigned int m_Current;
+	// Set after the draws of the frame that wrote each section
+	GLsync m_Fences[ SECTIONS ];
+
+public:
+	// @param sectionSize: Bytes written each frame
+	explicit VertexBufferRing( unsigned int sectionSize );
+	~VertexBufferRing();
+
+	VertexBufferRing( const VertexBufferRing & ) = delete;
+	VertexBufferRing &operator=( const VertexBufferRing & ) = delete;
+
+	// @return the section of a new frame to write, once the GPU is done with what it held
+	void *Begin();
+	// After the draws of the frame reading the section
+	void End();
+
+	inline unsigned int GetSection() const{ return m_Current; }
+	inline unsigned int GetSectionSize() const{ return m_SectionSize; }
+	// @return bytes from the start of the buffer to the current section
+	inline unsigned int GetOffset() const{ return m_Current * m_SectionSize; }
+	inline const VertexBuffer &GetBuffer() const{ return m_Buffer; }
+};
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include <glm/glm.hpp>
+
+/*
+ * Vertex formats described once at compile time. A format is a struct with a constexpr list of
+ * attributes, and from that list come the CPU packing ( TriangleT::Write ), the GL layout
+ * ( VertexBufferLayout::FromFormat ) and the GLSL inputs of the vertex shader ( GlslVertexInputs ),
+ * so the three can't drift apart. A new format only needs a new struct here.
+ *
+ * Attributes are laid out in order without gaps and the stride is rounded up to 4 bytes. Every
+ * attribute reaches the shader as floats ( glVertexAttribPointer ), integers that aren't normalized
+ * keep their value, like the byte texture index.
+ */
+
+// What an attribute holds, TriangleT::Write knows how to produce each one
+enum class VertexSemantic{
+	Position,		// 3 components
+	TileColor,		// 3, blue for the 108 degree tiles and red for the 36 degree ones
+	Color,			// 3, the grey the textures are lit from
+	TexCoord,		// 2
+	TexCoordLayer,	// 3, texture coords and the layer of the tile
+	TexIndex,		// 1, sampler of the tile in project.shader
+	Normal,			// 3
+	Tile,			// 1, type of the tile in bits 0-1 and corner of the vertex in bits 2-3, see TileFormat
+	Instance		// 4, TileInstance of an instanced draw, one per tile instead of per vertex
+};
+
+// Component types, the values are the GL enums so this header doesn't need GL
+enum class AttributeType : unsigned int{
+	Float = 0x1406,			// GL_FLOAT
+	HalfFloat = 0x140B,		// GL_HALF_FLOAT
+	UnsignedInt = 0x1405,	// GL_UNSIGNED_INT
+	UnsignedShort = 0x1403,	// GL_UNSIGNED_SHORT
+	UnsignedByte = 0x1401,	// GL_UNSIGNED_BYTE
+	Int2101010Rev = 0x8D9F	// GL_INT_2_10_10_10_REV, 4 signed normalized components in 32 bits
+};
+
+struct VertexAttribute{
+	VertexSemantic semantic;
+	AttributeType type;
+	unsigned int count;
+	bool normalized;
+	// Input name in the vertex shader
+	const char *name;
+};
+
+constexpr unsigned int SemanticComponents( VertexSemantic semantic ){
+	switch( semantic ){
+		case VertexSemantic::TexCoord: return 2;
+		case VertexSemantic::TexIndex: return 1;
+		case VertexSemantic::Tile: return 1;
+		case VertexSemantic::Instance: return 4;
+		default: return 3;
+	}
+}
+
+// @return bytes of one component, or of the whole attribute for the packed types
+constexpr unsigned int AttributeTypeSize( AttributeType type ){
+	switch( type ){
+		case AttributeType::HalfFloat: return 2;
+		case AttributeType::UnsignedShort: return 2;
+		case AttributeType::UnsignedByte: return 1;
+		default: return 4;
+	}
+}
+
+constexpr bool IsPackedType( AttributeType type ){
+	return type == AttributeType::Int2101010Rev;
+}
+
+constexpr unsigned int AttributeSize( const VertexAttribute &attribute ){
+	return IsPackedType( attribute.type ) ? AttributeTypeSize( attribute.type ) : attribute.count * AttributeTypeSize( attribute.type );
+}
+
+// @return bytes from the start of the vertex to the attribute
+template<typename Format>
+constexpr unsigned int AttributeOffset( size_t index ){
+	unsigned int offset = 0;
+	for( size_t i = 0; i < index; i++ )
+		offset += AttributeSize( Format::ATTRIBUTES[ i ] );
+	return offset;
+}
+
+// @return bytes between two vertices of the format
+template<typename Format>
+constexpr unsigned int VertexStride(){
+	return ( AttributeOffset<Format>( std::size( Format::ATTRIBUTES ) ) + 3 ) / 4 * 4;
+}
+
+// @return true when the attributes can be packed and fetched: enough components for their semantic,
+// packed types with 4 components on 4 byte boundaries and every other one aligned to its component
+template<typename Format>
+constexpr bool IsValidFormat(){
+	for( size_t i = 0; i < std::size( Format::ATTRIBUTES ); i++ ){
+		const VertexAttribute &attribute = Format::ATTRIBUTES[ i ];
+		if( attribute.count < SemanticComponents( attribute.semantic ) || attribute.count > 4 )
+			return false;
+		if( IsPackedType( attribute.type ) && ( attribute.count != 4 || AttributeOffset<Format>( i ) % 4 ) )
+			return false;
+		if( AttributeOffset<Format>( i ) % AttributeTypeSize( attribute.type ) )
+			return false;
+	}
+	return true;
+}
+
+// @return true when every attribute is float and has the components of its semantic, what TriangleT::Write packs
+template<typename Format>
+constexpr bool IsFloatFormat(){
+	for( const VertexAttribute &attribute : Format::ATTRIBUTES )
+		if( attribute.type != AttributeType::Float || attribute.count != SemanticComponents( attribute.semantic ) )
+			return false;
+	return true;
+}
+
+template<typename Format>
+constexpr bool HasSemantic( VertexSemantic semantic ){
+	for( const VertexAttribute &attribute : Format::ATTRIBUTES )
+		if( attribute.semantic == semantic )
+			return true;
+	return false;
+}
+
+/*
+ * Encoders of the packed types. glm has them in gtc/packing but goes through std::round and a
+ * generic half conversion, about 15 ns per value, these are a few instructions each.
+ */
+
+// @return the half float nearest to value, ties to even, overflow goes to infinity
+inline uint16_t FloatToHalf( float value ){
+	const uint32_t F32_INFINITY = 255u << 23;
+	const uint32_t F16_OVERFLOW = ( 127u + 16u ) << 23;
+	// Adding it as a float shifts a subnormal half into the low bits with the FPU rounding
+	const uint32_t DENORMAL_MAGIC = ( ( 127u - 15u ) + ( 23u - 10u ) + 1u ) << 23;
+
+	uint32_t bits;
+	memcpy( &bits, &value, sizeof( bits ) );
+	uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint16_t half;
+	if( bits >= F16_OVERFLOW ){
+		half = bits > F32_INFINITY ? 0x7e00 : 0x7c00;
+	} else if( bits < ( 113u << 23 ) ){
+		float magic, shifted;
+		memcpy( &magic, &DENORMAL_MAGIC, sizeof( magic ) );
+		memcpy( &shifted, &bits, sizeof( shifted ) );
+		shifted += magic;
+		memcpy( &bits, &shifted, sizeof( bits ) );
+		half = ( uint16_t ) ( bits - DENORMAL_MAGIC );
+	} else{
+		uint32_t odd = ( bits >> 13 ) & 1;
+		bits += ( ( uint32_t ) ( 15 - 127 ) << 23 ) + 0xfff + odd;
+		half = ( uint16_t ) ( bits >> 13 );
+	}
+	return ( uint16_t ) ( half | ( sign >> 16 ) );
+}
+
+// @return value in [0, 1] as an unsigned normalized integer of max steps, rounded to nearest
+inline uint32_t PackUnorm( float value, float max ){
+	return ( uint32_t ) ( glm::clamp( value, 0.0f, 1.0f ) * max + 0.5f );
+}
+
+// @return value in [-1, 1] as a signed normalized integer of max steps, rounded half away from zero
+inline int32_t PackSnorm( float value, float max ){
+	float scaled = glm::clamp( value, -1.0f, 1.0f ) * max;
+	return ( int32_t ) ( scaled + ( scaled < 0.0f ? -0.5f : 0.5f ) );
+}
+
+// @return x, y and z in 10 bits each from the lowest and w in the 2 top ones, the GL_INT_2_10_10_10_REV layout
+inline uint32_t PackSnorm3x10_1x2( const glm::vec4 &value ){
+	return ( ( uint32_t ) PackSnorm( value.x, 511.0f ) & 0x3ff ) |
+		( ( ( uint32_t ) PackSnorm( value.y, 511.0f ) & 0x3ff ) << 10 ) |
+		( ( ( uint32_t ) PackSnorm( value.z, 511.0f ) & 0x3ff ) << 20 ) |
+		( ( ( uint32_t ) PackSnorm( value.w, 1.0f ) & 0x3 ) << 30 );
+}
+
+/**
+ * Store the first count components of value in the type of the attribute
+ *
+ * @return the byte past the attribute
+ */
+template<AttributeType Type, unsigned int Count, bool Normalized>
+unsigned char *EncodeAttribute( unsigned char *out, const glm::vec4 &value ){
+	if constexpr( Type == AttributeType::Int2101010Rev ){
+		uint32_t packed = PackSnorm3x10_1x2( value );
+		memcpy( out, &packed, sizeof( packed ) );
+		return out + sizeof( packed );
+	} else{
+		for( unsigned int i = 0; i < Count; i++ ){
+			if constexpr( Type == AttributeType::Float ){
+				float component = value[ i ];
+				memcpy( out, &component, sizeof( component ) );
+			} else if constexpr( Type == AttributeType::HalfFloat ){
+				uint16_t component = FloatToHalf( value[ i ] );
+				memcpy( out, &component, sizeof( component ) );
+			} else if constexpr( Type == AttributeType::UnsignedShort ){
+				uint16_t component = ( uint16_t ) ( Normalized ? PackUnorm( value[ i ], 65535.0f ) : value[ i ] );
+				memcpy( out, &component, sizeof( component ) );
+			} else if constexpr( Type == AttributeType::UnsignedByte ){
+				*out = ( uint8_t ) ( Normalized ? PackUnorm( value[ i ], 255.0f ) : value[ i ] );
+			} else{
+				uint32_t component = ( uint32_t ) value[ i ];
+				memcpy( out, &component, sizeof( component ) );
+			}
+			out += AttributeTypeSize( Type );
+		}
+		return out;
+	}
+}
+
+// @return the name of the HAS_ define of the semantic in the vertex shader
+constexpr const char *SemanticDefine( VertexSemantic semantic ){
+	switch( semantic ){
+		case VertexSemantic::Position: return "HAS_POSITION";
+		case VertexSemantic::TileColor: return "HAS_TILE_COLOR";
+		case VertexSemantic::Color: return "HAS_COLOR";
+		case VertexSemantic::TexCoord: return "HAS_TEX_COORD";
+		case VertexSemantic::TexCoordLayer: return "HAS_TEX_COORD_LAYER";
+		case VertexSemantic::TexIndex: return "HAS_TEX_INDEX";
+		case VertexSemantic::Normal: return "HAS_NORMAL";
+		case VertexSemantic::Tile: return "HAS_TILE";
+		default: return "HAS_INSTANCE";
+	}
+}
+
+/**
+ * @return the "layout( location = N ) in ..." lines of the format, attribute N at location N, each one
+ * after a "#define HAS_<SEMANTIC>" so the shader can derive what the format doesn't carry
+ *
+ * @param firstLocation: Location of the first attribute, for a second buffer like the instances
+ */
+template<typename Format>
+std::string GlslVertexInputs( unsigned int firstLocation = 0 ){
+	static const char *FLOAT_TYPES[] = { "", "float", "vec2", "vec3", "vec4" };
+
+	// Declared with the components of the semantic, the extra ones of a packed attribute are dropped
+	std::string inputs;
+	unsigned int location = firstLocation;
+	for( const VertexAttribute &attribute : Format::ATTRIBUTES ){
+		inputs += std::string( "#define " ) + SemanticDefine( attribute.semantic ) + "\n";
+		inputs += "layout( location = " + std::to_string( location++ ) + " ) in " +
+			FLOAT_TYPES[ SemanticComponents( attribute.semantic ) ] + " " + attribute.name + ";\n";
+	}
+	return inputs;
+}
+
+// 3 floats per vertex: position
+struct PositionFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+	};
+};
+
+// 6 floats per vertex: position and the color of the tile
+struct PositionColorFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+		{ VertexSemantic::TileColor, AttributeType::Float, 3, false, "o_Color" },
+	};
+};
+
+// 6 floats per vertex: position, texture coords and layer
+struct PositionTexCoordFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+		{ VertexSemantic::TexCoordLayer, AttributeType::Float, 3, false, "texCoord" },
+	};
+};
+
+// 9 floats per vertex: position, color, texture coords and texture index
+struct PositionColorTexCoordFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+		{ VertexSemantic::Color, AttributeType::Float, 3, false, "o_Color" },
+		{ VertexSemantic::TexCoord, AttributeType::Float, 2, false, "texCoord" },
+		{ VertexSemantic::TexIndex, AttributeType::Float, 1, false, "o_TexIndex" },
+	};
+};
+
+// 12 floats per vertex: same as above followed by the normal for the light, the layout of the renderer
+struct PositionColorTexCoordNormalFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+		{ VertexSemantic::Color, AttributeType::Float, 3, false, "o_Color" },
+		{ VertexSemantic::TexCoord, AttributeType::Float, 2, false, "texCoord" },
+		{ VertexSemantic::TexIndex, AttributeType::Float, 1, false, "o_TexIndex" },
+		{ VertexSemantic::Normal, AttributeType::Float, 3, false, "aNormal" },
+	};
+};
+
+/*
+ * Packed formats, for PenroseT::PackVertices. Normals are 10 bits per component, the color is RGBA8,
+ * texture coords are 8 bit unorm and the texture index is a byte. The texture coords are approximate:
+ * 0 and 1 are exact but the 0.5 of the apex is stored as 128 / 255, off by 1 / 510, under a texel of
+ * the textures up to 255 pixels wide and a fraction of one above that.
+ */
+
+// 24 bytes per vertex, half of PositionColorTexCoordNormalFormat
+struct PackedFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+		{ VertexSemantic::Normal, AttributeType::Int2101010Rev, 4, true, "aNormal" },
+		{ VertexSemantic::Color, AttributeType::UnsignedByte, 4, true, "o_Color" },
+		{ VertexSemantic::TexCoord, AttributeType::UnsignedByte, 2, true, "texCoord" },
+		{ VertexSemantic::TexIndex, AttributeType::UnsignedByte, 1, false, "o_TexIndex" },
+	};
+};
+
+// 20 bytes per vertex with half float positions, about 1e-3 of precision for a tilling of diameter 1
+struct PackedHalfFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Normal, AttributeType::Int2101010Rev, 4, true, "aNormal" },
+		{ VertexSemantic::Color, AttributeType::UnsignedByte, 4, true, "o_Color" },
+		{ VertexSemantic::Position, AttributeType::HalfFloat, 3, false, "aPos" },
+		{ VertexSemantic::TexCoord, AttributeType::UnsignedByte, 2, true, "texCoord" },
+		{ VertexSemantic::TexIndex, AttributeType::UnsignedByte, 1, false, "o_TexIndex" },
+	};
+};
+
+/*
+ * Attribute-less shading: the texture coords, the grey and the sampler of a vertex all follow from the
+ * type of its tile and its corner, so only the position and one byte with the type are stored and
+ * project.shader derives the rest ( HAS_TILE ). The corner is taken from gl_VertexID % 3, which needs
+ * the vertices drawn in order, it is in the byte as well for draws that don't. The normal comes from the
+ * face in the geometry shader like for every other format.
+ */
+
+// 16 bytes per vertex
+struct TileFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::Float, 3, false, "aPos" },
+		{ VertexSemantic::Tile, AttributeType::UnsignedByte, 1, false, "a_Tile" },
+	};
+};
+
+// 8 bytes per vertex, the positions have the precision of PackedHalfFormat
+struct TileHalfFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Position, AttributeType::HalfFloat, 3, false, "aPos" },
+		{ VertexSemantic::Tile, AttributeType::UnsignedByte, 1, false, "a_Tile" },
+	};
+};
+
+static_assert( VertexStride<PackedFormat>() == 24 && VertexStride<PackedHalfFormat>() == 20, "Packed formats changed size" );
+static_assert( VertexStride<TileFormat>() == 16 && VertexStride<TileHalfFormat>() == 8, "Tile formats changed size" );
+
+// Per instance buffer of the instanced draw, TileFormat prototypes placed by a TileInstance each
+struct TileInstanceFormat{
+	static constexpr VertexAttribute ATTRIBUTES[] = {
+		{ VertexSemantic::Instance, AttributeType::Float, 4, false, "a_Instance" },
+	};
+};
+
+// The float formats above by value, for code choosing one at run time
+enum class VertexFormat{
+	Position,
+	PositionColor,
+	PositionTexCoord,
+	PositionColorTexCoord,
+	PositionColorTexCoordNormal
+};
+
+template<typename Format>
+struct FormatTag{
+	typedef Format type;
+};
+
+// Calls fn( FormatTag<Format>() ) with the struct of the format
+template<typename Func>
+auto VisitVertexFormat( VertexFormat format, Func fn ){
+	switch( format ){
+		case VertexFormat::Position: return fn( FormatTag<PositionFormat>() );
+		case VertexFormat::PositionColor: return fn( FormatTag<PositionColorFormat>() );
+		case VertexFormat::PositionTexCoord: return fn( FormatTag<PositionTexCoordFormat>() );
+		case VertexFormat::PositionColorTexCoord: return fn( FormatTag<PositionColorTexCoordFormat>() );
+		default: return fn( FormatTag<PositionColorTexCoordNormalFormat>() );
+	}
+}
+
+// @return the floats of one vertex in the format
+inline size_t FloatsPerVertex( VertexFormat format ){
+	return VisitVertexFormat( format, []( auto tag ){
+		return ( size_t ) VertexStride<typename decltype( tag )::type>() / sizeof( float );
+	} );
+}